@@ -0,0 +1,454 @@
+/**
+ * Benchmarks of the hot paths of dynamic_array against std::vector, across element sizes and
+ * element counts: push_back/emplace_back with and without a pre-sized capacity, copy
+ * construction, move assignment, shift_remove/swap_remove, clear() and both searches; indexed
+ * loops under each bounds-check policy; key lookups by linearSearch(), flat_map and
+ * flat_hash_map against std::unordered_map; and sums, transforms and filters of whole arrays,
+ * sequential and through parallel_algorithms.
+ *
+ * Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers, and run with
+ * --benchmark_filter=<regex> to select benchmarks, e.g. --benchmark_filter=PushBack.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "dynamic_array.h"
+#include "flat_hash_map.h"
+#include "flat_map.h"
+#include "parallel_algorithms.h"
+
+/// A trivially copyable record of N bytes, compared by its key.
+template <std::size_t N>
+struct Item {
+    static_assert(N > sizeof(std::uint32_t), "an item holds a key plus payload");
+    Item() = default;
+    Item(std::uint32_t k) : key(k) { std::memset(payload, 0, sizeof(payload)); }
+    bool operator==(const Item &other) const { return key == other.key; }
+    bool operator<(const Item &other) const { return key < other.key; }
+
+    std::uint32_t key;
+    unsigned char payload[N - sizeof(std::uint32_t)];
+};
+
+/// Element factories: the key order matches the integer order.
+template <typename T>
+T make(std::uint32_t i) { return T(i); }
+template <>
+std::string make<std::string>(std::uint32_t i)
+{
+    // Longer than the small-string buffer, so every copy allocates.
+    std::string s = std::to_string(i);
+    return std::string(24 - s.size(), '0') + s;
+}
+
+/// Adapters over the interfaces of the two containers.
+template <typename T>
+using darray = dynamic_array<T>;
+
+template <typename T>
+void shift_remove(std::vector<T> &v, std::size_t i) { v.erase(v.begin() + i); }
+template <typename T>
+void shift_remove(darray<T> &a, std::size_t i) { a.shift_remove(i); }
+
+template <typename T>
+void swap_remove(std::vector<T> &v, std::size_t i)
+{
+    std::swap(v[i], v.back());
+    v.pop_back();
+}
+template <typename T>
+void swap_remove(darray<T> &a, std::size_t i) { a.swap_remove(i); }
+
+template <typename T>
+std::size_t linear_search(const std::vector<T> &v, const T &x)
+{
+    return std::find(v.begin(), v.end(), x) - v.begin();
+}
+template <typename T>
+std::size_t linear_search(const darray<T> &a, const T &x) { return a.linearSearch(x); }
+
+template <typename T>
+std::size_t binary_search(const std::vector<T> &v, const T &x)
+{
+    return std::lower_bound(v.begin(), v.end(), x) - v.begin();
+}
+template <typename T>
+std::size_t binary_search(const darray<T> &a, const T &x) { return a.binarySearch(x); }
+
+template <typename C>
+C filled(std::size_t count)
+{
+    using T = typename std::remove_reference<decltype(std::declval<C&>()[0])>::type;
+    C c;
+    c.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        c.push_back(make<T>(std::uint32_t(i)));
+    }
+    return c;
+}
+
+template <typename C, typename T>
+void PushBack(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    T value = make<T>(1);
+    for (auto _ : state) {
+        C c;
+        for (std::size_t i = 0; i < count; i++) {
+            c.push_back(value);
+        }
+        benchmark::DoNotOptimize(c.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename C, typename T>
+void PushBackReserved(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    T value = make<T>(1);
+    for (auto _ : state) {
+        C c;
+        c.reserve(count);
+        for (std::size_t i = 0; i < count; i++) {
+            c.push_back(value);
+        }
+        benchmark::DoNotOptimize(c.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename C, typename T>
+void EmplaceBack(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    for (auto _ : state) {
+        C c;
+        for (std::size_t i = 0; i < count; i++) {
+            c.emplace_back(make<T>(std::uint32_t(i)));
+        }
+        benchmark::DoNotOptimize(c.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename C, typename T>
+void EmplaceBackReserved(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    for (auto _ : state) {
+        C c;
+        c.reserve(count);
+        for (std::size_t i = 0; i < count; i++) {
+            c.emplace_back(make<T>(std::uint32_t(i)));
+        }
+        benchmark::DoNotOptimize(c.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename C, typename T>
+void CopyConstruct(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    C source = filled<C>(count);
+    for (auto _ : state) {
+        C copy(source);
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename C, typename T>
+void MoveAssign(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    C a = filled<C>(count), b;
+    for (auto _ : state) {
+        b = std::move(a);
+        a = std::move(b);
+        benchmark::DoNotOptimize(a.data());
+    }
+}
+
+template <typename C, typename T>
+void ShiftRemove(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    C source = filled<C>(count);
+    for (auto _ : state) {
+        state.PauseTiming();
+        C c(source);
+        state.ResumeTiming();
+        // Remove a sixteenth of the items, spread over the whole array.
+        for (std::size_t i = 0; i < count / 16; i++) {
+            shift_remove(c, (i * 15) % (count - i));
+        }
+        benchmark::DoNotOptimize(c.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (count / 16));
+}
+
+template <typename C, typename T>
+void SwapRemove(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    C source = filled<C>(count);
+    for (auto _ : state) {
+        state.PauseTiming();
+        C c(source);
+        state.ResumeTiming();
+        for (std::size_t i = 0; i < count / 2; i++) {
+            swap_remove(c, (i * 7) % (count - i));
+        }
+        benchmark::DoNotOptimize(c.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (count / 2));
+}
+
+template <typename C, typename T>
+void Clear(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    C source = filled<C>(count);
+    for (auto _ : state) {
+        state.PauseTiming();
+        C c(source);
+        state.ResumeTiming();
+        c.clear();
+        benchmark::DoNotOptimize(c.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename C, typename T>
+void LinearSearch(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    C c = filled<C>(count);
+    std::uint32_t key = 0;
+    for (auto _ : state) {
+        // Search for keys spread over the array, plus a missing one every so often.
+        key = (key + 7919) % (count + count / 8 + 1);
+        benchmark::DoNotOptimize(linear_search(c, make<T>(key)));
+    }
+    state.SetItemsProcessed(state.iterations() * count / 2);
+}
+
+template <typename C, typename T>
+void BinarySearch(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    C c = filled<C>(count);
+    std::uint32_t key = 0;
+    for (auto _ : state) {
+        key = (key + 7919) % (count + 1);
+        benchmark::DoNotOptimize(binary_search(c, make<T>(key)));
+    }
+}
+
+/// Key lookups: a linear search of the keys of an array, and the maps, all holding the values
+/// of keys spread over [0, 2^32).
+struct LinearKeys {
+    dynamic_array<std::uint32_t> keys;
+    dynamic_array<std::uint32_t> values;
+
+    void insert(std::uint32_t key, std::uint32_t value) { keys.push_back(key); values.push_back(value); }
+    const std::uint32_t *find(std::uint32_t key) const
+    {
+        unsigned int index = keys.linearSearch(key);
+        return index < keys.size() ? &values[index] : nullptr;
+    }
+};
+struct UnorderedMap {
+    std::unordered_map<std::uint32_t, std::uint32_t> map;
+
+    void insert(std::uint32_t key, std::uint32_t value) { map.emplace(key, value); }
+    const std::uint32_t *find(std::uint32_t key) const
+    {
+        auto it = map.find(key);
+        return it == map.end() ? nullptr : &it->second;
+    }
+};
+template <typename Map>
+struct FlatMap {
+    Map map;
+
+    void insert(std::uint32_t key, std::uint32_t value) { map.insert(key, value); }
+    const std::uint32_t *find(std::uint32_t key) const { return map.find(key); }
+};
+
+std::uint32_t spread_key(std::uint32_t i)
+{
+    return i * 2654435761u;
+}
+
+/// Look up random keys, of which half are in the map.
+template <typename M>
+void KeyLookup(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    M m;
+    for (std::size_t i = 0; i < count; i++) {
+        m.insert(spread_key(std::uint32_t(i * 2)), std::uint32_t(i));
+    }
+    std::uint32_t i = 0;
+    for (auto _ : state) {
+        i = (i + 7919) % std::uint32_t(count * 2);
+        benchmark::DoNotOptimize(m.find(spread_key(i)));
+    }
+}
+
+BENCHMARK_TEMPLATE(KeyLookup, LinearKeys)->RangeMultiplier(8)->Range(64, 1 << 15);
+BENCHMARK_TEMPLATE(KeyLookup, UnorderedMap)->RangeMultiplier(8)->Range(64, 1 << 18);
+BENCHMARK_TEMPLATE(KeyLookup, FlatMap<flat_map<std::uint32_t, std::uint32_t>>)->RangeMultiplier(8)->Range(64, 1 << 18);
+BENCHMARK_TEMPLATE(KeyLookup, FlatMap<flat_hash_map<std::uint32_t, std::uint32_t>>)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+/// Bulk passes over an array, sequential (threads = 0 in the arguments) or through
+/// parallel_algorithms with the given number of threads.
+darray<std::uint32_t> bulk_input(std::size_t count)
+{
+    darray<std::uint32_t> a;
+    for (std::size_t i = 0; i < count; i++) {
+        a.push_back(spread_key(std::uint32_t(i)));
+    }
+    return a;
+}
+
+void BulkSum(benchmark::State &state)
+{
+    darray<std::uint32_t> a = bulk_input(state.range(0));
+    unsigned int threads = unsigned(state.range(1));
+    for (auto _ : state) {
+        std::uint64_t sum = threads ? parallel_algorithms::reduce(a.begin(), a.end(), std::uint64_t(0), std::plus<std::uint64_t>(), threads)
+                                    : std::accumulate(a.begin(), a.end(), std::uint64_t(0));
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * a.size());
+}
+
+void BulkTransform(benchmark::State &state)
+{
+    darray<std::uint32_t> a = bulk_input(state.range(0));
+    darray<std::uint32_t> out(a.size(), 0u);
+    unsigned int threads = unsigned(state.range(1));
+    auto f = [](std::uint32_t x) { return x * 3 + (x >> 7); };
+    for (auto _ : state) {
+        if (threads) {
+            parallel_algorithms::transform(a.begin(), a.end(), out.begin(), f, threads);
+        }
+        else {
+            std::transform(a.begin(), a.end(), out.begin(), f);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * a.size());
+}
+
+/// Keep about half of the items: sequentially by push_back() into a reserved array, or in
+/// parallel into a pre-sized one.
+void BulkCopyIf(benchmark::State &state)
+{
+    darray<std::uint32_t> a = bulk_input(state.range(0));
+    unsigned int threads = unsigned(state.range(1));
+    auto keep = [](std::uint32_t x) { return (x & 0x100) != 0; };
+    for (auto _ : state) {
+        darray<std::uint32_t> out;
+        if (threads) {
+            out.resize_uninitialized(a.size());
+            out.resize_uninitialized(unsigned(parallel_algorithms::copy_if(a.begin(), a.end(), out.begin(), keep, threads) - out.begin()));
+        }
+        else {
+            out.reserve(a.size());
+            for (std::uint32_t x : a) {
+                if (keep(x)) {
+                    out.push_back(x);
+                }
+            }
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * a.size());
+}
+
+#define CONTAINERS_BULK_BENCHMARK(name) \
+    BENCHMARK(name)->ArgsProduct({{1 << 16, 1 << 22}, {0, 1, 2, 4, 8}})->UseRealTime()
+
+CONTAINERS_BULK_BENCHMARK(BulkSum);
+CONTAINERS_BULK_BENCHMARK(BulkTransform);
+CONTAINERS_BULK_BENCHMARK(BulkCopyIf);
+
+/// Arrays differing only in their bounds-check policy.
+template <typename T>
+using checked_darray = dynamic_array<T, unsigned int, aligned_allocator<T>, doubling_growth, no_stats, bounds_checked>;
+template <typename T>
+using unchecked_darray = dynamic_array<T, unsigned int, aligned_allocator<T>, doubling_growth, no_stats, bounds_unchecked>;
+
+/// Element access through operator[], or through at_unchecked() on a checked array.
+struct Subscript {
+    template <typename C>
+    static auto get(const C &c, decltype(c.size()) i) -> decltype(c[i]) { return c[i]; }
+};
+struct AtUnchecked {
+    template <typename C>
+    static auto get(const C &c, decltype(c.size()) i) -> decltype(c.at_unchecked(i)) { return c.at_unchecked(i); }
+};
+
+/// Sum the items in an indexed loop, which the compiler can only vectorize if the access does not
+/// branch on the index.
+template <typename C, typename T, typename Access>
+void IndexedSum(benchmark::State &state)
+{
+    std::size_t count = state.range(0);
+    C c = filled<C>(count);
+    // Loop up to a count kept apart from the array, as when indexing several arrays at once, so
+    // that the compiler cannot tell the loop condition implies the bounds check.
+    auto n = decltype(c.size())(count);
+    for (auto _ : state) {
+        T sum = 0;
+        for (decltype(n) i = 0; i < n; i++) {
+            sum += Access::get(c, i);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+#define CONTAINERS_BOUNDS_BENCHMARK(type)                                                                            \
+    BENCHMARK_TEMPLATE(IndexedSum, std::vector<type>, type, Subscript)->RangeMultiplier(8)->Range(64, 1 << 18);      \
+    BENCHMARK_TEMPLATE(IndexedSum, checked_darray<type>, type, Subscript)->RangeMultiplier(8)->Range(64, 1 << 18);   \
+    BENCHMARK_TEMPLATE(IndexedSum, checked_darray<type>, type, AtUnchecked)->RangeMultiplier(8)->Range(64, 1 << 18); \
+    BENCHMARK_TEMPLATE(IndexedSum, unchecked_darray<type>, type, Subscript)->RangeMultiplier(8)->Range(64, 1 << 18)
+
+CONTAINERS_BOUNDS_BENCHMARK(std::uint32_t);
+CONTAINERS_BOUNDS_BENCHMARK(std::uint64_t);
+
+#define CONTAINERS_BENCHMARK(name, type)                                                      \
+    BENCHMARK_TEMPLATE(name, std::vector<type>, type)->RangeMultiplier(8)->Range(64, 1 << 18); \
+    BENCHMARK_TEMPLATE(name, darray<type>, type)->RangeMultiplier(8)->Range(64, 1 << 18)
+
+#define CONTAINERS_BENCHMARK_ALL_TYPES(name)     \
+    CONTAINERS_BENCHMARK(name, std::uint32_t);   \
+    CONTAINERS_BENCHMARK(name, Item<16>);        \
+    CONTAINERS_BENCHMARK(name, Item<64>);        \
+    CONTAINERS_BENCHMARK(name, std::string)
+
+CONTAINERS_BENCHMARK_ALL_TYPES(PushBack);
+CONTAINERS_BENCHMARK_ALL_TYPES(PushBackReserved);
+CONTAINERS_BENCHMARK_ALL_TYPES(EmplaceBack);
+CONTAINERS_BENCHMARK_ALL_TYPES(EmplaceBackReserved);
+CONTAINERS_BENCHMARK_ALL_TYPES(CopyConstruct);
+CONTAINERS_BENCHMARK_ALL_TYPES(MoveAssign);
+CONTAINERS_BENCHMARK_ALL_TYPES(ShiftRemove);
+CONTAINERS_BENCHMARK_ALL_TYPES(SwapRemove);
+CONTAINERS_BENCHMARK_ALL_TYPES(Clear);
+CONTAINERS_BENCHMARK_ALL_TYPES(LinearSearch);
+CONTAINERS_BENCHMARK_ALL_TYPES(BinarySearch);
+
+BENCHMARK_MAIN();
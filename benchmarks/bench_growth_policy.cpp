@@ -0,0 +1,100 @@
+/**
+ * Compare the growth policies of dynamic_array: fill an array by push_back() and report the
+ * number of reallocations, the peak number of bytes allocated at once, the final capacity, the
+ * time taken and the peak resident set size.
+ *
+ * Each policy runs in a child process, so that the peak RSS reported by getrusage() belongs to
+ * that policy only.
+ *
+ * Usage: bench_growth_policy [number of items]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "dynamic_array.h"
+
+struct AllocStats {
+    static std::size_t Allocs;
+    static std::size_t Bytes;
+    static std::size_t PeakBytes;
+};
+
+std::size_t AllocStats::Allocs = 0;
+std::size_t AllocStats::Bytes = 0;
+std::size_t AllocStats::PeakBytes = 0;
+
+/// An allocator recording the number of allocations and the peak of allocated bytes.
+template <typename T>
+class StatsAllocator {
+public:
+    using value_type = T;
+
+    StatsAllocator() = default;
+    template <typename U>
+    StatsAllocator(const StatsAllocator<U> &) {}
+    T *allocate(std::size_t n)
+    {
+        AllocStats::Allocs++;
+        AllocStats::Bytes += n * sizeof(T);
+        if (AllocStats::Bytes > AllocStats::PeakBytes) {
+            AllocStats::PeakBytes = AllocStats::Bytes;
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, std::size_t n)
+    {
+        AllocStats::Bytes -= n * sizeof(T);
+        ::operator delete(ptr);
+    }
+    template <typename U>
+    bool operator==(const StatsAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const StatsAllocator<U> &) const { return false; }
+};
+
+template <typename G>
+void run(const char *name, std::size_t count)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid > 0) {
+        int status;
+        waitpid(pid, &status, 0);
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    dynamic_array<std::uint64_t, std::size_t, StatsAllocator<std::uint64_t>, G> items;
+    for (std::size_t i = 0; i < count; i++) {
+        items.push_back(i);
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%-34s %12zu %14.1f %16zu %10.1f %14.1f\n", name, AllocStats::Allocs,
+           AllocStats::PeakBytes / 1048576.0, items.capacity(), elapsed.count(),
+           usage.ru_maxrss / 1024.0);
+    fflush(stdout);
+    _exit(0);
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+    printf("push_back() of %zu 8-byte items\n", count);
+    printf("%-34s %12s %14s %16s %10s %14s\n", "policy", "allocations", "peak alloc MB",
+           "capacity", "time ms", "peak RSS MB");
+    run<doubling_growth>("doubling_growth", count);
+    run<geometric_growth<>>("geometric_growth<3, 2>", count);
+    run<geometric_growth<3, 2, 4096>>("geometric_growth<3, 2, 4K>", count);
+    run<geometric_growth<3, 2, 64, 16 << 20>>("geometric_growth<3, 2, 64, 16M>", count);
+    run<geometric_growth<2, 1, 4096, 16 << 20>>("geometric_growth<2, 1, 4K, 16M>", count);
+    return 0;
+}
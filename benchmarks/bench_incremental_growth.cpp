@@ -0,0 +1,72 @@
+/**
+ * Compare the latency of push_back() on dynamic_array and incremental_dynamic_array: fill each
+ * array with 16-byte items and report the total time, the median, 99.9th percentile and worst
+ * latencies of a single push_back(), and the time of the slowest 0.1% of the calls added up.
+ *
+ * dynamic_array relocates all its items when it grows, so its worst push_back() grows with the
+ * size of the array; incremental_dynamic_array relocates a few items per push_back() after a
+ * growth, so its worst case is bounded by an allocation.
+ *
+ * Usage: bench_incremental_growth [number of items (default 16M)]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "dynamic_array.h"
+#include "incremental_dynamic_array.h"
+
+struct Item {
+    Item(std::uint64_t k) : key(k), value(k) {}
+    std::uint64_t key;
+    std::uint64_t value;
+};
+
+/// An item with a noexcept move constructor, which arrays relocate by moving it.
+struct MovableItem {
+    MovableItem(std::uint64_t k) : key(k), value(k) {}
+    MovableItem(const MovableItem &other) = default;
+    MovableItem(MovableItem &&other) noexcept : key(other.key), value(other.value) {}
+    std::uint64_t key;
+    std::uint64_t value;
+};
+
+template <typename Array, typename T>
+void run(const char *name, std::size_t count)
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<std::uint32_t> latencies(count);
+    Array a;
+    clock::time_point start = clock::now();
+    clock::time_point previous = start;
+    for (std::size_t i = 0; i < count; i++) {
+        a.push_back(T(std::uint64_t(i)));
+        clock::time_point now = clock::now();
+        latencies[i] = std::uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now - previous).count());
+        previous = now;
+    }
+    double total = std::chrono::duration<double>(previous - start).count();
+    std::sort(latencies.begin(), latencies.end());
+    std::size_t tail = count / 1000;
+    double tail_ms = 0;
+    for (std::size_t i = count - tail; i < count; i++) {
+        tail_ms += latencies[i] / 1e6;
+    }
+    std::printf("%-40s %9.1f %9u %9u %11.3f %11.1f\n", name, total * 1e3, latencies[count / 2],
+                latencies[count - 1 - tail], latencies[count - 1] / 1e6, tail_ms);
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t(1) << 24;
+    std::printf("%zu push_back() calls of 16-byte items (latencies include the clock reads)\n", count);
+    std::printf("%-40s %9s %9s %9s %11s %11s\n", "array", "total ms", "p50 ns", "p99.9 ns", "worst ms",
+                "top 0.1% ms");
+    run<dynamic_array<Item, std::size_t>, Item>("dynamic_array (realloc)", count);
+    run<incremental_dynamic_array<Item, std::size_t>, Item>("incremental_dynamic_array", count);
+    run<dynamic_array<MovableItem, std::size_t>, MovableItem>("dynamic_array, non-trivial items", count);
+    run<incremental_dynamic_array<MovableItem, std::size_t>, MovableItem>("incremental_dynamic_array, non-trivial", count);
+    return 0;
+}
@@ -0,0 +1,209 @@
+/**
+ * Compare the placements of numa_allocator on large arrays: for each placement, fill an array of
+ * 8-byte items (by several threads), then scan it sequentially (by one thread and by all of them)
+ * and read it at random indices, reporting the bandwidth or latency and the dTLB load misses of
+ * each phase, plus the memory backed by transparent huge pages.
+ *
+ * The TLB misses come from perf_event_open() and read "n/a" where it is not permitted (see
+ * /proc/sys/kernel/perf_event_paranoid) or the CPU exposes no such counter, e.g. in most VMs.
+ * Explicit huge pages need a reserved pool, e.g.
+ *
+ *     echo 512 > /sys/kernel/mm/hugepages/hugepages-2048kB/nr_hugepages
+ *
+ * and fall back to transparent huge pages otherwise. On a multi-socket machine, compare
+ * "interleave" and "bind 0" when run with the threads spread over both sockets; on a single
+ * node, the NUMA policies all behave the same.
+ *
+ * Usage: bench_numa_allocator [megabytes (default 1024)] [threads (default all)]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "dynamic_array.h"
+#include "numa_allocator.h"
+
+/// A counter of the dTLB load misses of the process (threads included), or an invalid one.
+class TlbMisses {
+public:
+    TlbMisses()
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = int(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (m_fd >= 0) {
+            ::ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    ~TlbMisses()
+    {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+    /// Format the misses per 1000 items, or "n/a", into 'buf'.
+    void per_1000(std::size_t items, char *buf, std::size_t size)
+    {
+        long long count = 0;
+        if (m_fd < 0 || ::read(m_fd, &count, sizeof(count)) != sizeof(count)) {
+            std::snprintf(buf, size, "n/a");
+        }
+        else {
+            std::snprintf(buf, size, "%.2f", 1000.0 * double(count) / double(items));
+        }
+    }
+private:
+    int m_fd;
+};
+
+/// Return the memory of the process backed by transparent huge pages, in MB.
+double huge_page_mb()
+{
+    FILE *f = std::fopen("/proc/self/smaps_rollup", "r");
+    if (!f) {
+        return 0;
+    }
+    char line[256];
+    double kb = 0;
+    while (std::fgets(line, sizeof(line), f)) {
+        if (std::strncmp(line, "AnonHugePages:", 14) == 0) {
+            kb = std::atof(line + 14);
+        }
+    }
+    std::fclose(f);
+    return kb / 1024;
+}
+
+/// Run f(i, begin, end) for 'threads' contiguous chunks of [0, count) on as many threads.
+template <typename F>
+void in_parallel(unsigned int threads, std::size_t count, F f)
+{
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back([=] { f(i, count * i / threads, count * (i + 1) / threads); });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename A>
+void run(const char *name, const A &alloc, std::size_t count, unsigned int threads)
+{
+    char tlb_seq[32], tlb_par[32], tlb_rand[32];
+    double huge_before = huge_page_mb();
+    dynamic_array<std::uint64_t, std::size_t, A> items(alloc);
+    items.resize_uninitialized(count);
+    std::uint64_t *data = items.data();
+
+    // Each thread writes its own chunk first, which is what first-touch placement relies on.
+    auto start = std::chrono::steady_clock::now();
+    in_parallel(threads, count, [data](unsigned int, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            data[i] = i * 2654435761u;
+        }
+    });
+    double fill = seconds_since(start);
+    double huge = huge_page_mb() - huge_before;
+
+    const int passes = 4;
+    std::uint64_t sum = 0;
+    start = std::chrono::steady_clock::now();
+    {
+        TlbMisses misses;
+        for (int pass = 0; pass < passes; pass++) {
+            for (std::size_t i = 0; i < count; i++) {
+                sum += data[i];
+            }
+        }
+        misses.per_1000(count * passes, tlb_seq, sizeof(tlb_seq));
+    }
+    double sequential = seconds_since(start);
+
+    std::vector<std::uint64_t> sums(threads);
+    start = std::chrono::steady_clock::now();
+    {
+        TlbMisses misses;
+        for (int pass = 0; pass < passes; pass++) {
+            in_parallel(threads, count, [data, &sums](unsigned int t, std::size_t begin, std::size_t end) {
+                std::uint64_t s = 0;
+                for (std::size_t i = begin; i < end; i++) {
+                    s += data[i];
+                }
+                sums[t] += s;
+            });
+        }
+        misses.per_1000(count * passes, tlb_par, sizeof(tlb_par));
+    }
+    double parallel = seconds_since(start);
+
+    // Random reads: one TLB lookup per item, so this is where huge pages pay off most.
+    const std::size_t reads = 1 << 24;
+    std::uint64_t index = 12345;
+    start = std::chrono::steady_clock::now();
+    {
+        TlbMisses misses;
+        for (std::size_t i = 0; i < reads; i++) {
+            index = index * 6364136223846793005ull + 1442695040888963407ull;
+            sum += data[(index >> 16) % count];
+        }
+        misses.per_1000(reads, tlb_rand, sizeof(tlb_rand));
+    }
+    double random = seconds_since(start);
+
+    double gb = double(count * sizeof(std::uint64_t) * passes) / 1e9;
+    std::printf("%-26s %8.1f %9.0f %10.2f %8s %10.2f %8s %9.1f %8s\n", name, fill * 1e3, huge,
+                gb / sequential, tlb_seq, gb / parallel, tlb_par, random * 1e9 / reads, tlb_rand);
+    std::fflush(stdout);
+    if (sum == 42) {
+        std::printf("%llu\n", (unsigned long long)(sum + sums[0]));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024;
+    unsigned int threads = argc > 2 ? unsigned(std::atoi(argv[2])) : 0;
+    if (!threads) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    std::size_t count = (megabytes << 20) / sizeof(std::uint64_t);
+    std::printf("%zu MB of 8-byte items, %u thread(s); dTLB load misses per 1000 items\n", megabytes, threads);
+    std::printf("%-26s %8s %9s %10s %8s %10s %8s %9s %8s\n", "placement", "fill ms", "THP MB",
+                "seq GB/s", "TLB", "par GB/s", "TLB", "rand ns", "TLB");
+
+    using alloc = numa_allocator<std::uint64_t>;
+    run("malloc (aligned_allocator)", aligned_allocator<std::uint64_t>(), count, threads);
+    run("mapped, 4K pages", alloc(memory_placement()), count, threads);
+    run("transparent huge pages", alloc(memory_placement().with_pages(page_kind::transparent_huge)), count, threads);
+    run("explicit 2M pages", alloc(memory_placement().with_pages(page_kind::huge_2mb)), count, threads);
+    run("explicit 1G pages", alloc(memory_placement().with_pages(page_kind::huge_1gb)), count, threads);
+    run("first touch", alloc(memory_placement::first_touch()), count, threads);
+    run("interleave", alloc(memory_placement::interleaved()), count, threads);
+    run("interleave, THP", alloc(memory_placement::interleaved().with_pages(page_kind::transparent_huge)),
+        count, threads);
+    run("bind 0", alloc(memory_placement::bound_to(0)), count, threads);
+    return 0;
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * \brief An allocator returning storage aligned to at least alignof(T) and to Align bytes.
+ *
+ * Plain ::operator new (and therefore std::allocator before C++17) only guarantees fundamental
+ * alignment (alignof(std::max_align_t)), which is not enough for over-aligned types such as
+ * __m256 or structs declared alignas(64). This allocator honours max(alignof(T), Align):
+ *  - When that alignment is fundamental it simply forwards to std::malloc.
+ *  - Otherwise it over-allocates, aligns the returned pointer and stores the original pointer
+ *    right before it, so that it can be handed back to std::free.
+ *
+ * Over-aligned blocks are also padded to a multiple of the alignment, so that a block aligned to
+ * a cache line (Align = 64) never shares a cache line with a neighbouring allocation.
+ *
+ * Blocks come from malloc rather than ::operator new so that reallocate() can resize them with
+ * std::realloc, which extends a block in place when the heap allows it (and, for the large blocks
+ * glibc maps with mmap, moves it with mremap instead of copying); see allocator_has_reallocate.
+ *
+ * The allocator is stateless and all instances compare equal.
+ */
+template <typename T, std::size_t Align = alignof(T)>
+class aligned_allocator {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    /// The effective alignment of the returned storage.
+    static constexpr std::size_t alignment = Align > alignof(T) ? Align : alignof(T);
+    static_assert((alignment & (alignment - 1)) == 0, "alignment must be a power of two");
+
+    template <typename U>
+    struct rebind {
+        using other = aligned_allocator<U, Align>;
+    };
+
+    aligned_allocator() = default;
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Align> &)
+    {}
+
+    /// Allocate uninitialized storage for n objects of type T.
+    T *allocate(std::size_t n)
+    {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(allocate_bytes(n * sizeof(T), over_aligned()));
+    }
+    /// Release storage previously returned by allocate().
+    void deallocate(T *ptr, std::size_t)
+    {
+        deallocate_bytes(ptr, over_aligned());
+    }
+    /// Resize storage for 'old_n' objects to hold 'new_n' objects, keeping the bytes of the first
+    /// min(old_n, new_n) objects; the block may move. Return the resized block, or nullptr (with
+    /// the original block left untouched) if there is not enough memory.
+    T *reallocate(T *ptr, std::size_t old_n, std::size_t new_n)
+    {
+        if (new_n > max_size()) {
+            return nullptr;
+        }
+        std::size_t kept = (old_n < new_n ? old_n : new_n) * sizeof(T);
+        return static_cast<T*>(reallocate_bytes(ptr, kept, new_n * sizeof(T), over_aligned()));
+    }
+    /// The maximum number of objects that can be requested by allocate().
+    std::size_t max_size() const
+    {
+        return (static_cast<std::size_t>(-1) - 2 * alignment) / sizeof(T);
+    }
+
+    template <typename U>
+    bool operator==(const aligned_allocator<U, Align> &) const { return true; }
+    template <typename U>
+    bool operator!=(const aligned_allocator<U, Align> &) const { return false; }
+
+private:
+    using over_aligned = std::integral_constant<bool, (alignment > alignof(std::max_align_t))>;
+
+    static void *allocate_raw(std::size_t bytes)
+    {
+        void *raw = std::malloc(bytes ? bytes : 1);
+        if (!raw) {
+            throw std::bad_alloc();
+        }
+        return raw;
+    }
+    static std::size_t padded(std::size_t bytes)
+    {
+        return (bytes + alignment - 1) & ~(alignment - 1);
+    }
+    /// Return the aligned address within a raw block, leaving room for the raw pointer.
+    static void **aligned_within(void *raw)
+    {
+        std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(raw) + alignment) & ~(alignment - 1);
+        return reinterpret_cast<void**>(aligned);
+    }
+    static void *allocate_bytes(std::size_t bytes, std::false_type)
+    {
+        return allocate_raw(bytes);
+    }
+    static void *allocate_bytes(std::size_t bytes, std::true_type)
+    {
+        // Pad to whole alignment units; the extra unit holds the original pointer. Since malloc
+        // returns at least max_align_t aligned memory, there are always enough bytes before the
+        // aligned address to store it.
+        void *raw = allocate_raw(padded(bytes) + alignment);
+        void **ptr = aligned_within(raw);
+        ptr[-1] = raw;
+        return ptr;
+    }
+    static void deallocate_bytes(void *ptr, std::false_type)
+    {
+        std::free(ptr);
+    }
+    static void deallocate_bytes(void *ptr, std::true_type)
+    {
+        std::free(static_cast<void**>(ptr)[-1]);
+    }
+    static void *reallocate_bytes(void *ptr, std::size_t, std::size_t bytes, std::false_type)
+    {
+        return std::realloc(ptr, bytes ? bytes : 1);
+    }
+    static void *reallocate_bytes(void *ptr, std::size_t kept, std::size_t bytes, std::true_type)
+    {
+        // realloc keeps the bytes at the same offset from the start of the raw block, which may no
+        // longer be the aligned one; move them there if so.
+        void *raw = static_cast<void**>(ptr)[-1];
+        std::ptrdiff_t offset = static_cast<char*>(ptr) - static_cast<char*>(raw);
+        void *moved = std::realloc(raw, padded(bytes) + alignment);
+        if (!moved) {
+            return nullptr;
+        }
+        void **aligned = aligned_within(moved);
+        char *kept_at = static_cast<char*>(moved) + offset;
+        if (reinterpret_cast<char*>(aligned) != kept_at) {
+            std::memmove(aligned, kept_at, kept);
+        }
+        aligned[-1] = moved;
+        return aligned;
+    }
+};
+
+template <typename T, std::size_t Align>
+constexpr std::size_t aligned_allocator<T, Align>::alignment;
+
+/**
+ * \brief Trait detecting allocators that can resize a block, possibly in place.
+ *
+ * Such an allocator has a member function
+ *
+ *     T *reallocate(T *ptr, std::size_t old_n, std::size_t new_n);
+ *
+ * resizing a block from allocate() (bytewise, like std::realloc) and returning nullptr, with the
+ * block untouched, when it cannot. The arrays use it to grow trivially relocatable items without
+ * holding the old and the new buffer at the same time, falling back to allocate, relocate and
+ * deallocate when it returns nullptr. An allocator that can only extend blocks in place (e.g. by
+ * mremap without MREMAP_MAYMOVE) returns nullptr when that fails.
+ */
+template <typename A, typename = void>
+struct allocator_has_reallocate : std::false_type {};
+
+template <typename A>
+struct allocator_has_reallocate<A, decltype((void)std::declval<A&>().reallocate(
+    std::declval<typename A::value_type*>(), std::size_t(), std::size_t()))> : std::true_type {};
@@ -0,0 +1,602 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <stdexcept>
+#include "simd_search.h"
+
+/**
+ * \brief Trait specifying whether objects of type T are trivially relocatable.
+ *
+ * An object is trivially relocatable when moving it to a new address and ending the lifetime of
+ * the source (move-construct, then destroy) is equivalent to copying its bytes with memcpy. This
+ * holds for all trivially copyable types, which are detected automatically; for other types (e.g.
+ * std::unique_ptr or handle classes owning a resource through a pointer) it can be enabled with a
+ * specialization:
+ *
+ *     template <> struct is_trivially_relocatable<MyHandle> : std::true_type {};
+ */
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+/**
+ * \brief Algorithms shared by the array containers, working on a raw range of 'size' objects
+ * starting at 'data'.
+ */
+namespace array_algorithms {
+
+namespace detail {
+
+template <typename T, typename L>
+void relocate(T *dst, T *src, L count, std::true_type)
+{
+    if (count) {
+        std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+    }
+}
+
+template <typename T, typename L>
+void relocate(T *dst, T *src, L count, std::false_type)
+{
+    L i = 0;
+    try {
+        for (; i < count; i++) {
+            new (dst + i) T(std::move_if_noexcept(src[i]));
+        }
+    }
+    catch (...) {
+        for (L j = 0; j < i; j++) {
+            dst[j].~T();
+        }
+        throw;
+    }
+    for (i = 0; i < count; i++) {
+        src[i].~T();
+    }
+}
+
+template <typename T, typename L>
+void shift_remove(T *data, L size, L index, std::true_type)
+{
+    data[index].~T();
+    std::memmove(static_cast<void*>(data + index),
+                 static_cast<const void*>(data + index + 1),
+                 (size - index - 1) * sizeof(T));
+}
+
+template <typename T, typename L>
+void shift_remove(T *data, L size, L index, std::false_type)
+{
+    for (L i = index + 1; i < size; i++) {
+        data[i - 1] = std::move(data[i]);
+    }
+    data[size - 1].~T();
+}
+
+template <typename T>
+void swap_remove(T *item, T *last, std::true_type)
+{
+    item->~T();
+    if (item != last) {
+        std::memcpy(static_cast<void*>(item), static_cast<const void*>(last), sizeof(T));
+    }
+}
+
+template <typename T>
+void swap_remove(T *item, T *last, std::false_type)
+{
+    using std::swap;
+    if (item != last) {
+        swap(*item, *last);
+    }
+    last->~T();
+}
+
+template <typename T, typename L>
+void uninitialized_copy(T *dst, const T *src, L count, std::true_type)
+{
+    if (count) {
+        std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+    }
+}
+
+template <typename T, typename L>
+void uninitialized_copy(T *dst, const T *src, L count, std::false_type)
+{
+    L i = 0;
+    try {
+        for (; i < count; i++) {
+            new (dst + i) T(src[i]);
+        }
+    }
+    catch (...) {
+        for (L j = 0; j < i; j++) {
+            dst[j].~T();
+        }
+        throw;
+    }
+}
+
+template <typename T, typename L>
+void uninitialized_fill(T *dst, const T &value, L count, std::true_type)
+{
+    for (L i = 0; i < count; i++) {
+        new (dst + i) T(value);
+    }
+}
+
+template <typename T, typename L>
+void uninitialized_fill(T *dst, const T &value, L count, std::false_type)
+{
+    L i = 0;
+    try {
+        for (; i < count; i++) {
+            new (dst + i) T(value);
+        }
+    }
+    catch (...) {
+        for (L j = 0; j < i; j++) {
+            dst[j].~T();
+        }
+        throw;
+    }
+}
+
+template <typename T, typename L>
+L find(const T *data, L size, const T &value, std::true_type)
+{
+    return L(simd::find(data, std::size_t(size), value));
+}
+
+template <typename T, typename L>
+L find(const T *data, L size, const T &value, std::false_type)
+{
+    L i = 0;
+    while (i < size && !(data[i] == value)) { i++; }
+    return i;
+}
+
+template <typename T, typename L>
+L count(const T *data, L size, const T &value, std::true_type)
+{
+    return L(simd::count(data, std::size_t(size), value));
+}
+
+template <typename T, typename L>
+L count(const T *data, L size, const T &value, std::false_type)
+{
+    L n = 0;
+    for (L i = 0; i < size; i++) {
+        n += data[i] == value;
+    }
+    return n;
+}
+
+template <bool Max, typename T, typename L>
+L extremum(const T *data, L size, std::false_type)
+{
+    L best = 0;
+    for (L i = 1; i < size; i++) {
+        if (Max ? data[best] < data[i] : data[i] < data[best]) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+template <bool Max, typename T, typename L>
+L extremum(const T *data, L size, std::true_type)
+{
+    if (simd::minmax_available()) {
+        return L(Max ? simd::max_index(data, std::size_t(size)) : simd::min_index(data, std::size_t(size)));
+    }
+    return extremum<Max>(data, size, std::false_type());
+}
+
+/// Compact the objects for which removed(i) is false to the front in one pass, destroying the
+/// others; trivially relocatable runs of kept objects are moved with a single memmove each.
+template <typename T, typename L, typename Removed>
+L compact(T *data, L size, Removed removed, std::true_type)
+{
+    L w = 0, i = 0;
+    while (i < size) {
+        // Find the next run of kept objects, then the removed object ending it (if any).
+        L run = i;
+        while (i < size && !removed(i)) { i++; }
+        if (w != run && i != run) {
+            std::memmove(static_cast<void*>(data + w), static_cast<const void*>(data + run),
+                         (i - run) * sizeof(T));
+        }
+        w += i - run;
+        if (i < size) {
+            data[i++].~T();
+        }
+    }
+    return w;
+}
+
+template <typename T, typename L, typename Removed>
+L compact(T *data, L size, Removed removed, std::false_type)
+{
+    L w = 0;
+    for (L i = 0; i < size; i++) {
+        if (!removed(i)) {
+            if (w != i) {
+                data[w] = std::move(data[i]);
+            }
+            w++;
+        }
+    }
+    for (L i = w; i < size; i++) {
+        data[i].~T();
+    }
+    return w;
+}
+
+template <typename T, typename L>
+void fill_hole(T *data, L index, L last, std::true_type)
+{
+    data[index].~T();
+    if (index != last) {
+        std::memcpy(static_cast<void*>(data + index), static_cast<const void*>(data + last), sizeof(T));
+    }
+}
+
+template <typename T, typename L>
+void fill_hole(T *data, L index, L last, std::false_type)
+{
+    if (index != last) {
+        data[index] = std::move(data[last]);
+    }
+    data[last].~T();
+}
+
+template <typename T, typename L>
+void shift_insert(T *data, L size, L index, T &&value, std::true_type)
+{
+    std::memmove(static_cast<void*>(data + index + 1), static_cast<const void*>(data + index),
+                 (size - index) * sizeof(T));
+    new (data + index) T(std::move(value));
+}
+
+template <typename T, typename L>
+void shift_insert(T *data, L size, L index, T &&value, std::false_type)
+{
+    if (index == size) {
+        new (data + size) T(std::move(value));
+        return;
+    }
+    new (data + size) T(std::move(data[size - 1]));
+    std::move_backward(data + index, data + size - 1, data + size);
+    data[index] = std::move(value);
+}
+
+/// Unsigned keys whose order matches the order of the arithmetic values they encode, for radix
+/// sorting: the sign bit of signed integers is flipped, and so are all bits of negative floats.
+template <typename T, typename = void>
+struct radix_key {
+    static const bool sortable = false;
+};
+
+template <typename T>
+struct radix_key<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+    static const bool sortable = true;
+    using type = typename std::make_unsigned<T>::type;
+    static const type sign = std::is_signed<T>::value ? type(type(1) << (sizeof(T) * 8 - 1)) : type(0);
+
+    static type encode(T value) { return type(type(value) ^ sign); }
+    static T decode(type key) { return T(type(key ^ sign)); }
+};
+
+template <typename T>
+struct radix_key<T, typename std::enable_if<std::is_floating_point<T>::value &&
+                                            (sizeof(T) == 4 || sizeof(T) == 8)>::type> {
+    static const bool sortable = true;
+    using type = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+    static const type sign = type(type(1) << (sizeof(T) * 8 - 1));
+
+    static type encode(T value)
+    {
+        type bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        return bits & sign ? type(~bits) : type(bits | sign);
+    }
+    static T decode(type key)
+    {
+        type bits = key & sign ? type(key ^ sign) : type(~key);
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+};
+
+/// Below this size a comparison sort beats the passes of a radix sort.
+const std::size_t radix_sort_threshold = 256;
+
+/// LSD radix sort on bytes, skipping the bytes in which all keys agree.
+template <typename T, typename L>
+void sort(T *data, L size, std::true_type)
+{
+    if (size < radix_sort_threshold) {
+        std::sort(data, data + size);
+        return;
+    }
+    using key = radix_key<T>;
+    using U = typename key::type;
+    const std::size_t bytes = sizeof(U);
+    std::unique_ptr<U[]> buffer(new U[2 * std::size_t(size)]);
+    U *keys = buffer.get(), *scratch = keys + size;
+    std::unique_ptr<std::size_t[]> counts(new std::size_t[bytes * 256]());
+    for (L i = 0; i < size; i++) {
+        U k = key::encode(data[i]);
+        keys[i] = k;
+        for (std::size_t b = 0; b < bytes; b++) {
+            counts[b * 256 + ((k >> (8 * b)) & 0xff)]++;
+        }
+    }
+    for (std::size_t b = 0; b < bytes; b++) {
+        std::size_t *count = counts.get() + b * 256;
+        if (count[(keys[0] >> (8 * b)) & 0xff] == std::size_t(size)) {
+            continue;
+        }
+        std::size_t offset = 0;
+        for (std::size_t d = 0; d < 256; d++) {
+            std::size_t n = count[d];
+            count[d] = offset;
+            offset += n;
+        }
+        for (L i = 0; i < size; i++) {
+            scratch[count[(keys[i] >> (8 * b)) & 0xff]++] = keys[i];
+        }
+        std::swap(keys, scratch);
+    }
+    for (L i = 0; i < size; i++) {
+        data[i] = key::decode(keys[i]);
+    }
+}
+
+template <typename T, typename L>
+void sort(T *data, L size, std::false_type)
+{
+    std::sort(data, data + size);
+}
+
+/// Merge 'count' sorted items into the 'size' sorted items at 'data', which has room for them,
+/// from the back, so that no item is moved twice.
+template <typename T, typename L, typename Less>
+void merge_into(T *data, L size, const T *items, L count, Less less, std::true_type)
+{
+    L i = size, j = count, k = size + count;
+    while (j > 0) {
+        if (i > 0 && less(items[j - 1], data[i - 1])) {
+            std::memcpy(static_cast<void*>(data + --k), static_cast<const void*>(data + --i), sizeof(T));
+        }
+        else {
+            std::memcpy(static_cast<void*>(data + --k), static_cast<const void*>(items + --j), sizeof(T));
+        }
+    }
+}
+
+template <typename T, typename L, typename Less>
+void merge_into(T *data, L size, const T *items, L count, Less less, std::false_type)
+{
+    uninitialized_copy(data + size, items, count, typename std::is_trivially_copyable<T>::type());
+    std::inplace_merge(data, data + size, data + size + count, less);
+}
+
+} // namespace detail
+
+/// Relocate 'count' objects from 'src' into uninitialized memory at 'dst', leaving 'src'
+/// uninitialized: a single memcpy for trivially relocatable types, otherwise construct each object
+/// in its new place, then destroy the originals. Objects are moved if their move constructor is
+/// noexcept (or they cannot be copied) and copied otherwise (std::move_if_noexcept), so that if a
+/// constructor throws, the objects already constructed are destroyed and 'src' is left intact.
+template <typename T, typename L>
+void relocate(T *dst, T *src, L count)
+{
+    detail::relocate(dst, src, count, typename is_trivially_relocatable<T>::type());
+}
+
+/// Copy-construct 'count' objects from 'src' into uninitialized memory at 'dst': a single memcpy
+/// for trivially copyable types. If a copy throws, the objects already constructed are destroyed.
+template <typename T, typename L>
+void uninitialized_copy(T *dst, const T *src, L count)
+{
+    detail::uninitialized_copy(dst, src, count, typename std::is_trivially_copyable<T>::type());
+}
+
+/// Copy-construct 'count' copies of 'value' into uninitialized memory at 'dst': a plain store loop
+/// (which compilers turn into memset or vector stores) for trivially copyable types. If a copy
+/// throws, the objects already constructed are destroyed.
+template <typename T, typename L>
+void uninitialized_fill(T *dst, const T &value, L count)
+{
+    detail::uninitialized_fill(dst, value, count, typename std::is_trivially_copyable<T>::type());
+}
+
+/// Remove the object at 'index' by shifting back all objects next to it. The last slot is left
+/// uninitialized; the caller is responsible for decrementing the size.
+template <typename T, typename L>
+void shift_remove(T *data, L size, L index)
+{
+    detail::shift_remove(data, size, index, typename is_trivially_relocatable<T>::type());
+}
+
+/// Remove the object at 'index' by moving the last one on top of it. The last slot is left
+/// uninitialized; the caller is responsible for decrementing the size.
+template <typename T, typename L>
+void swap_remove(T *data, L size, L index)
+{
+    detail::swap_remove(data + index, data + size - 1, typename is_trivially_relocatable<T>::type());
+}
+
+/// Remove the object at 'item' by moving the one at 'last' (e.g. the last item of a chunked
+/// array) on top of it; 'last' is left uninitialized. Unless the objects are trivially
+/// relocatable they are swapped first, so if that throws both are still alive.
+template <typename T>
+void swap_remove(T *item, T *last)
+{
+    detail::swap_remove(item, last, typename is_trivially_relocatable<T>::type());
+}
+
+/// Insert an object at 'index' by shifting forward all objects from there on; the slot at 'size'
+/// must be uninitialized storage, and the caller is responsible for incrementing the size.
+template <typename T, typename L>
+void shift_insert(T *data, L size, L index, T &&value)
+{
+    detail::shift_insert(data, size, index, std::move(value), typename is_trivially_relocatable<T>::type());
+}
+
+/// Sort objects by operator<: with a radix sort for integers and floats (negative zero before
+/// zero, and NaNs at the ends according to their sign bit), with std::sort otherwise.
+template <typename T, typename L>
+void sort(T *data, L size)
+{
+    detail::sort(data, size, std::integral_constant<bool, detail::radix_key<T>::sortable>());
+}
+
+/// Merge 'count' objects sorted by 'less' into the 'size' objects sorted by 'less' at 'data',
+/// which must have room for them (uninitialized storage); equal objects keep their order, the
+/// ones already at 'data' first. The caller is responsible for increasing the size by 'count'.
+template <typename T, typename L, typename Less>
+void merge_into(T *data, L size, const T *items, L count, Less less)
+{
+    detail::merge_into(data, size, items, count, less, typename std::is_trivially_copyable<T>::type());
+}
+
+/// Remove the objects for which pred(item) holds, keeping the order of the others, in a single
+/// pass. Return the new size; the slots past it are left uninitialized.
+template <typename T, typename L, typename Pred>
+L remove_if(T *data, L size, Pred pred)
+{
+    return detail::compact(data, size, [data, &pred](L i) { return bool(pred(data[i])); },
+                           typename is_trivially_relocatable<T>::type());
+}
+
+/// Remove the objects in the index range [first, last), shifting the tail back once. Return
+/// the new size; the slots past it are left uninitialized.
+template <typename T, typename L>
+L erase(T *data, L size, L first, L last)
+{
+    return detail::compact(data, size, [first, last](L i) { return i >= first && i < last; },
+                           typename is_trivially_relocatable<T>::type());
+}
+
+/// Remove the objects at the 'count' indices listed in ascending order (duplicates allowed), in a
+/// single pass. Return the new size; the slots past it are left uninitialized.
+template <typename T, typename L>
+L erase_indices(T *data, L size, const L *indices, L count)
+{
+    L k = 0;
+    return detail::compact(data, size, [indices, count, &k](L i) {
+        bool removed = false;
+        while (k < count && indices[k] == i) {
+            removed = true;
+            k++;
+        }
+        return removed;
+    }, typename is_trivially_relocatable<T>::type());
+}
+
+/// Remove the objects for which pred(item) holds, filling each hole with the last object;
+/// does not keep the order, but moves only one object per removal. Return the new size; the
+/// slots past it are left uninitialized.
+template <typename T, typename L, typename Pred>
+L swap_remove_if(T *data, L size, Pred pred)
+{
+    L i = 0;
+    while (i < size) {
+        if (pred(data[i])) {
+            detail::fill_hole(data, i, --size, typename is_trivially_relocatable<T>::type());
+        }
+        else {
+            i++;
+        }
+    }
+    return size;
+}
+
+/// Perform a linear search for a specific item; return the index of the first item for which
+/// pred(item, value) holds, or 'size' if there is none.
+template <typename T, typename L, typename V, typename Pred>
+L linear_search(const T *data, L size, V value, Pred pred)
+{
+    L i = 0;
+    while (i < size && !(pred(data[i], value))) { i++; }
+    return i;
+}
+
+/// Return the index of the first item equal to 'value' (using operator==), or 'size' if there
+/// is none. Uses SIMD kernels for arithmetic types.
+template <typename T, typename L>
+L find(const T *data, L size, const T &value)
+{
+    return detail::find(data, size, value, typename simd::has_kernels<T>::type());
+}
+
+/// Return the number of items equal to 'value' (using operator==). Uses SIMD kernels for
+/// arithmetic types.
+template <typename T, typename L>
+L count(const T *data, L size, const T &value)
+{
+    return detail::count(data, size, value, typename simd::has_kernels<T>::type());
+}
+
+/// Return the index of the first minimum item (using operator<), or 'size' if there is none.
+template <typename T, typename L>
+L min_index(const T *data, L size)
+{
+    return size ? detail::extremum<false>(data, size, typename simd::has_minmax_kernels<T>::type()) : size;
+}
+
+/// Return the index of the first maximum item (using operator<), or 'size' if there is none.
+template <typename T, typename L>
+L max_index(const T *data, L size)
+{
+    return size ? detail::extremum<true>(data, size, typename simd::has_minmax_kernels<T>::type()) : size;
+}
+
+/// Return the index of the first item for which less(item, value) does not hold, or 'size' if
+/// there is none. The loop is branchless: the comparison selects the next base with a
+/// conditional move, so it does not suffer from mispredictions.
+template <typename T, typename L, typename V, typename Less>
+L lower_bound(const T *data, L size, const V &value, Less less)
+{
+    if (size == 0) {
+        return 0;
+    }
+    const T *base = data;
+    L len = size;
+    while (len > 1) {
+        L half = len / 2;
+        base = less(base[half], value) ? base + half : base;
+        len -= half;
+    }
+    return L(base - data) + L(less(*base, value));
+}
+
+/// Perform a binary search on sorted items; pred(item, value) returns a negative number if the
+/// item is ordered before the value. Return the index of the first item not ordered before the
+/// value, or the last index if there is none (0 for an empty range).
+template <typename T, typename L, typename V, typename Pred>
+L binary_search(const T *data, L size, V value, Pred pred)
+{
+    L index = lower_bound(data, size, value, [&pred](const T &item, const V &v) { return pred(item, v) < 0; });
+    return index < size ? index : (size ? size - 1 : 0);
+}
+
+/// Perform a binary search on items sorted by operator<; same result as the above.
+template <typename T, typename L>
+L binary_search(const T *data, L size, const T &value)
+{
+    L index = lower_bound(data, size, value, [](const T &item, const T &v) { return item < v; });
+    return index < size ? index : (size ? size - 1 : 0);
+}
+
+} // namespace array_algorithms
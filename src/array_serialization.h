@@ -0,0 +1,261 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "dynamic_array.h"
+
+/**
+ * \brief Binary serialization of arrays of trivially copyable items, without copying on read.
+ *
+ * A serialized array is a 16-byte header followed by the raw bytes of the items, padded with
+ * zeros to a multiple of 16 bytes:
+ *
+ *     offset  size  field
+ *          0     4  magic "CTRA"
+ *          4     1  format version (2)
+ *          5     1  byte order of the writer (1: little endian, 2: big endian)
+ *          6     2  sizeof(T)
+ *          8     8  number of items
+ *         16     -  the items, exactly as they are in memory
+ *          -     -  0 to 15 zero bytes of padding
+ *
+ * All the header fields are in the writer's byte order, which the reader checks: a buffer
+ * written on a machine of the other byte order is rejected rather than silently misread.
+ *
+ * serialize() writes the header and the items into a buffer of serialized_size() bytes, and
+ * write() sends them to a file descriptor with a single writev() from the array's data(), with
+ * no intermediate copy. On the read side, view<T> aliases a received buffer: its items are used
+ * right where they are, and read() appends them to an array with a single memcpy. Several arrays
+ * can be written back to back; view::serialized_bytes() tells where the next one starts, and
+ * thanks to the padding its items are as aligned as those of the first one (for items aligned
+ * to at most 16 bytes).
+ */
+namespace array_serialization {
+
+/// Version of the format (2 added the padding).
+const std::uint8_t version = 2;
+/// Size of the header, which is also the offset of the items.
+const std::size_t header_size = 16;
+/// Serialized arrays are padded to a multiple of this size.
+const std::size_t padding_alignment = 16;
+
+/// Byte order tags.
+const std::uint8_t little_endian = 1;
+const std::uint8_t big_endian = 2;
+
+/// Return the byte order of this machine.
+inline std::uint8_t native_byte_order()
+{
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+    return __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ ? big_endian : little_endian;
+#else
+    const std::uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first ? little_endian : big_endian;
+#endif
+}
+
+/// The header preceding the items.
+struct header {
+    char magic[4];
+    std::uint8_t version;
+    std::uint8_t byte_order;
+    std::uint16_t item_size;
+    std::uint64_t count;
+};
+static_assert(sizeof(header) == header_size, "the header must be packed into 16 bytes");
+
+/// Return the header of a serialized array of 'count' items of type T.
+template <typename T>
+header make_header(std::uint64_t count)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "serialization requires a trivially copyable type");
+    static_assert(sizeof(T) <= 0xffff, "the item size must fit in 16 bits");
+    header h;
+    std::memcpy(h.magic, "CTRA", sizeof(h.magic));
+    h.version = version;
+    h.byte_order = native_byte_order();
+    h.item_size = std::uint16_t(sizeof(T));
+    h.count = count;
+    return h;
+}
+
+/// Return the number of bytes of the items of a serialized array of 'count' items of type T.
+template <typename T>
+std::size_t items_size(std::uint64_t count)
+{
+    return std::size_t(count) * sizeof(T);
+}
+
+/// Return the number of bytes of a serialized array of 'count' items of type T, padding included.
+template <typename T>
+std::size_t serialized_size(std::uint64_t count)
+{
+    std::size_t size = header_size + items_size<T>(count);
+    return (size + padding_alignment - 1) / padding_alignment * padding_alignment;
+}
+
+/// Serialize 'count' items into a buffer of 'bytes' bytes; return the number of bytes written.
+/// Throws std::length_error if the buffer is too small.
+template <typename T, typename L>
+std::size_t serialize(const T *data, L count, void *buffer, std::size_t bytes)
+{
+    std::size_t size = serialized_size<T>(count);
+    if (bytes < size) {
+        throw std::length_error("serialized array: buffer too small");
+    }
+    header h = make_header<T>(count);
+    unsigned char *out = static_cast<unsigned char*>(buffer);
+    std::memcpy(out, &h, header_size);
+    std::size_t items = items_size<T>(count);
+    if (count) {
+        std::memcpy(out + header_size, static_cast<const void*>(data), items);
+    }
+    std::memset(out + header_size + items, 0, size - header_size - items);
+    return size;
+}
+
+/// Serialize the items of an array (anything with data() and size()) into a buffer.
+template <typename Array>
+std::size_t serialize(const Array &array, void *buffer, std::size_t bytes)
+{
+    return serialize(array.data(), array.size(), buffer, bytes);
+}
+
+/// Write 'count' serialized items and their padding to a file descriptor with writev(), straight
+/// from 'data'; partial writes are resumed. Throws std::system_error if a write fails.
+template <typename T, typename L>
+void write(int fd, const T *data, L count)
+{
+    header h = make_header<T>(count);
+    static const unsigned char padding[padding_alignment] = {};
+    iovec parts[3];
+    parts[0].iov_base = &h;
+    parts[0].iov_len = header_size;
+    parts[1].iov_base = const_cast<void*>(static_cast<const void*>(data));
+    parts[1].iov_len = items_size<T>(count);
+    parts[2].iov_base = const_cast<unsigned char*>(padding);
+    parts[2].iov_len = serialized_size<T>(count) - header_size - parts[1].iov_len;
+    iovec *next = parts;
+    int remaining = 3;
+    while (remaining) {
+        ssize_t written = ::writev(fd, next, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "serialized array: writev");
+        }
+        // Skip the parts written completely, then the written bytes of the next one.
+        std::size_t done = std::size_t(written);
+        while (remaining && done >= next->iov_len) {
+            done -= next->iov_len;
+            next++;
+            remaining--;
+        }
+        if (remaining) {
+            next->iov_base = static_cast<unsigned char*>(next->iov_base) + done;
+            next->iov_len -= done;
+        }
+    }
+}
+
+/// Write the items of an array (anything with data() and size()) to a file descriptor.
+template <typename Array>
+void write(int fd, const Array &array)
+{
+    write(fd, array.data(), array.size());
+}
+
+/**
+ * \brief A read-only view of a serialized array, aliasing the buffer holding it.
+ *
+ * The buffer must outlive the view, and the items must be suitably aligned in it (the buffer
+ * itself aligned to alignof(T), since the header and the padding keep 16-byte alignment); the constructor checks
+ * the header, the length and the alignment and throws std::runtime_error if any is wrong.
+ */
+template <typename T, typename L = unsigned int>
+class view {
+    static_assert(std::is_trivially_copyable<T>::value, "serialization requires a trivially copyable type");
+public:
+    using length_t = L;
+
+    /// Parse the serialized array at the start of a buffer of 'bytes' bytes.
+    view(const void *buffer, std::size_t bytes)
+    {
+        if (bytes < header_size) {
+            throw std::runtime_error("serialized array: truncated header");
+        }
+        header h;
+        std::memcpy(&h, buffer, header_size);
+        if (std::memcmp(h.magic, "CTRA", sizeof(h.magic)) != 0) {
+            throw std::runtime_error("serialized array: bad magic");
+        }
+        if (h.version != version) {
+            throw std::runtime_error("serialized array: unsupported version " + std::to_string(h.version));
+        }
+        if (h.byte_order != native_byte_order()) {
+            throw std::runtime_error("serialized array: written with another byte order");
+        }
+        if (h.item_size != sizeof(T)) {
+            throw std::runtime_error("serialized array: items of a different size");
+        }
+        if (h.count > std::uint64_t(length_t(-1)) || h.count > (bytes - header_size) / sizeof(T) ||
+            serialized_size<T>(h.count) > bytes) {
+            throw std::runtime_error("serialized array: truncated items");
+        }
+        const unsigned char *items = static_cast<const unsigned char*>(buffer) + header_size;
+        if (reinterpret_cast<std::uintptr_t>(items) % alignof(T)) {
+            throw std::runtime_error("serialized array: misaligned items");
+        }
+        m_data = reinterpret_cast<const T*>(items);
+        m_size = length_t(h.count);
+    }
+    /// Return the number of items.
+    length_t size() const
+    {
+        return m_size;
+    }
+    /// Return the item at position 'index'; throws std::out_of_range if index >= size.
+    const T &operator[](length_t index) const
+    {
+        if (index >= m_size) {
+            throw std::out_of_range("index out of range");
+        }
+        return m_data[index];
+    }
+    /// Return raw access to the items, pointing into the buffer.
+    const T *data() const
+    {
+        return m_data;
+    }
+    /// Return the number of bytes of the serialized array (header and padding included); the
+    /// next one written to the same buffer starts there.
+    std::size_t serialized_bytes() const
+    {
+        return serialized_size<T>(m_size);
+    }
+private:
+    const T *m_data;
+    length_t m_size;
+};
+
+/// Append the items of the serialized array at the start of a buffer to 'array', with a single
+/// memcpy; return the number of bytes read. Throws std::runtime_error on a malformed buffer.
+template <typename T, typename L, typename A, typename G, typename S, typename B>
+std::size_t read(const void *buffer, std::size_t bytes, dynamic_array<T, L, A, G, S, B> &array)
+{
+    view<T, L> items(buffer, bytes);
+    array.append(items.data(), items.size());
+    return items.serialized_bytes();
+}
+
+} // namespace array_serialization
@@ -0,0 +1,200 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+/**
+ * \brief Statistics policies recording what an array does with its memory.
+ *
+ * A statistics policy is a class with the static member functions below, which the array calls
+ * on the corresponding events. With no_stats (the default) they are empty and inline, so they
+ * disappear completely from the generated code.
+ *
+ *     static void on_allocate(std::size_t bytes);
+ *     static void on_deallocate(std::size_t bytes);
+ *     static void on_grow(std::size_t old_capacity, std::size_t new_capacity, std::size_t size);
+ *     static void on_shrink(std::size_t old_capacity, std::size_t new_capacity, std::size_t size);
+ *     static void on_relocate(std::size_t count, std::size_t bytes, bool bytewise);
+ *     static void on_copy(std::size_t count);
+ *     static void on_size(std::size_t size);
+ *     static void on_release(std::size_t size, std::size_t capacity);
+ *
+ * on_relocate() reports the items moved to a new buffer while growing, either as one memcpy of
+ * 'bytes' bytes (bytewise, for trivially relocatable types) or as 'count' move-constructions;
+ * on_copy() reports items copy-constructed from another array or range; on_size() reports the
+ * new size of an array whenever items are added, so that the peak size is exact even for an
+ * array that never grows (e.g. reserved up front) and is emptied before it is destroyed;
+ * on_release() reports the size and the capacity of an array when it releases its buffer.
+ *
+ * site_stats<Site> accumulates the events of all the arrays declared with it into a global
+ * array_stats_site record, identified by a tag type declared with ARRAY_STATS_SITE(). The
+ * records of all sites are listed by array_stats_registry, e.g. to dump per-call-site totals
+ * and find the arrays that reallocate too often:
+ *
+ *     ARRAY_STATS_SITE(order_levels);
+ *     dynamic_array<level, unsigned int, aligned_allocator<level>, doubling_growth,
+ *                   site_stats<order_levels>> levels;
+ *     ...
+ *     array_stats_registry::dump(std::cerr);
+ *
+ * Defining CONTAINERS_NO_STATS turns every site_stats into no_stats, so that instrumented
+ * builds and release builds can share the same source.
+ */
+
+/// The statistics policy that records nothing.
+struct no_stats {
+    static void on_allocate(std::size_t) {}
+    static void on_deallocate(std::size_t) {}
+    static void on_grow(std::size_t, std::size_t, std::size_t) {}
+    static void on_shrink(std::size_t, std::size_t, std::size_t) {}
+    static void on_relocate(std::size_t, std::size_t, bool) {}
+    static void on_copy(std::size_t) {}
+    static void on_size(std::size_t) {}
+    static void on_release(std::size_t, std::size_t) {}
+};
+
+/// Totals of the events of all the arrays sharing a call site; all counters are updated
+/// atomically, so arrays may live in different threads.
+struct array_stats_site {
+    const char *name;
+    std::atomic<std::size_t> allocations;
+    std::atomic<std::size_t> bytes_allocated;
+    std::atomic<std::size_t> bytes_freed;
+    std::atomic<std::size_t> grows;
+    std::atomic<std::size_t> shrinks;
+    std::atomic<std::size_t> moves;
+    std::atomic<std::size_t> bytes_relocated;
+    std::atomic<std::size_t> copies;
+    std::atomic<std::size_t> peak_capacity;
+    std::atomic<std::size_t> peak_size;
+    array_stats_site *next;
+
+    explicit array_stats_site(const char *site_name);
+
+    /// Raise 'peak' to 'value' if it is lower.
+    static void update_peak(std::atomic<std::size_t> &peak, std::size_t value)
+    {
+        std::size_t current = peak.load(std::memory_order_relaxed);
+        while (current < value && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+};
+
+/// The list of all the call sites that recorded an event so far.
+class array_stats_registry {
+public:
+    /// Return the first site; the others follow through array_stats_site::next.
+    static array_stats_site *first()
+    {
+        return head().load(std::memory_order_acquire);
+    }
+    /// Add a site to the list (done by the array_stats_site constructor).
+    static void add(array_stats_site *site)
+    {
+        site->next = head().load(std::memory_order_relaxed);
+        while (!head().compare_exchange_weak(site->next, site, std::memory_order_release,
+                                             std::memory_order_relaxed)) {}
+    }
+    /// Print one line per site, sites growing most often first.
+    static void dump(std::ostream &out)
+    {
+        std::vector<const array_stats_site*> sites;
+        for (const array_stats_site *site = first(); site; site = site->next) {
+            sites.push_back(site);
+        }
+        std::sort(sites.begin(), sites.end(), [](const array_stats_site *a, const array_stats_site *b) {
+            return a->grows.load() > b->grows.load();
+        });
+        for (const array_stats_site *site : sites) {
+            out << site->name << ": grows:" << site->grows
+                << " shrinks:" << site->shrinks
+                << " allocations:" << site->allocations
+                << " bytes allocated:" << site->bytes_allocated
+                << " bytes freed:" << site->bytes_freed
+                << " moves:" << site->moves
+                << " bytes relocated:" << site->bytes_relocated
+                << " copies:" << site->copies
+                << " peak capacity:" << site->peak_capacity
+                << " peak size:" << site->peak_size << "\n";
+        }
+    }
+private:
+    static std::atomic<array_stats_site*> &head()
+    {
+        static std::atomic<array_stats_site*> sites(nullptr);
+        return sites;
+    }
+};
+
+inline array_stats_site::array_stats_site(const char *site_name)
+    : name(site_name), allocations(0), bytes_allocated(0), bytes_freed(0), grows(0), shrinks(0), moves(0),
+      bytes_relocated(0), copies(0), peak_capacity(0), peak_size(0), next(nullptr)
+{
+    array_stats_registry::add(this);
+}
+
+#define ARRAY_STATS_STRINGIFY_(x) #x
+#define ARRAY_STATS_STRINGIFY(x) ARRAY_STATS_STRINGIFY_(x)
+/// Declare a tag type naming a call site for site_stats.
+#define ARRAY_STATS_SITE(tag) \
+    struct tag { static const char *name() { return #tag " (" __FILE__ ":" ARRAY_STATS_STRINGIFY(__LINE__) ")"; } }
+
+#ifdef CONTAINERS_NO_STATS
+
+template <typename Site>
+struct site_stats : no_stats {};
+
+#else
+
+/// The statistics policy accumulating events into the record of the call site Site.
+template <typename Site>
+struct site_stats {
+    /// The record of the site, registered on first use.
+    static array_stats_site &site()
+    {
+        static array_stats_site record(Site::name());
+        return record;
+    }
+    static void on_allocate(std::size_t bytes)
+    {
+        site().allocations.fetch_add(1, std::memory_order_relaxed);
+        site().bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    static void on_deallocate(std::size_t bytes)
+    {
+        site().bytes_freed.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    static void on_grow(std::size_t, std::size_t new_capacity, std::size_t)
+    {
+        site().grows.fetch_add(1, std::memory_order_relaxed);
+        array_stats_site::update_peak(site().peak_capacity, new_capacity);
+    }
+    static void on_shrink(std::size_t, std::size_t, std::size_t)
+    {
+        site().shrinks.fetch_add(1, std::memory_order_relaxed);
+    }
+    static void on_relocate(std::size_t count, std::size_t bytes, bool bytewise)
+    {
+        if (bytewise) {
+            site().bytes_relocated.fetch_add(bytes, std::memory_order_relaxed);
+        }
+        else {
+            site().moves.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+    static void on_copy(std::size_t count)
+    {
+        site().copies.fetch_add(count, std::memory_order_relaxed);
+    }
+    static void on_size(std::size_t size)
+    {
+        array_stats_site::update_peak(site().peak_size, size);
+    }
+    static void on_release(std::size_t, std::size_t capacity)
+    {
+        array_stats_site::update_peak(site().peak_capacity, capacity);
+    }
+};
+
+#endif
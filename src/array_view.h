@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "array_algorithms.h"
+
+/**
+ * \brief A non-owning view of a contiguous range of objects: a pointer plus a length.
+ *
+ * Views are cheap to copy and never allocate, so read-only consumers can take an
+ * array_view<const T> instead of a const dynamic_array<T>&, or a slice of one through
+ * subview(). dynamic_array and small_dynamic_array convert to views implicitly:
+ *
+ *     double mean(array_view<const float> values);
+ *     ...
+ *     dynamic_array<float> samples;
+ *     mean(samples);                       // the whole array
+ *     mean(samples.view().subview(10, 5)); // items 10 to 14
+ *
+ * An array_view<T> over mutable items converts to an array_view<const T>. The view is
+ * invalidated by anything invalidating pointers to the items (e.g. growing the array). The
+ * searches are the ones of the containers (see array_algorithms.h).
+ */
+
+template <typename T, typename L = unsigned int>
+class array_view {
+public:
+    using length_t = L;
+    using value_type = typename std::remove_const<T>::type;
+
+    /// Construct an empty view.
+    array_view()
+        : m_data(nullptr), m_size(0)
+    {}
+    /// Construct a view of 'size' objects starting at 'data'.
+    array_view(T *data, length_t size)
+        : m_data(data), m_size(size)
+    {}
+    /// Construct a view of the objects in the range [first, last).
+    array_view(T *first, T *last)
+        : m_data(first), m_size(length_t(last - first))
+    {}
+    /// Convert a view of mutable objects into a view of const objects.
+    template <typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+    array_view(const array_view<U, L> &other)
+        : m_data(other.data()), m_size(other.size())
+    {}
+    /// Return the number of objects.
+    length_t size() const
+    {
+        return m_size;
+    }
+    /// Return whether the view is empty.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+    /// Return (a reference to) the object at position 'index'; throws std::out_of_range if index >= size.
+    T &operator[](length_t index) const
+    {
+        check_index(index);
+        return m_data[index];
+    }
+    /// Return the first object.
+    T &first() const { return (*this)[0]; }
+    /// Return the last object.
+    T &last() const { return (*this)[m_size - 1]; }
+    /// Return raw access to the objects.
+    T *data() const
+    {
+        return m_data;
+    }
+    T *begin() const
+    {
+        return m_data;
+    }
+    T *end() const
+    {
+        return m_data + m_size;
+    }
+    /// Return a view of 'count' objects starting at 'offset'; throws std::out_of_range if they
+    /// do not lie within this view.
+    array_view subview(length_t offset, length_t count) const
+    {
+        if (offset > m_size || count > m_size - offset) {
+            throw std::out_of_range("subview out of range");
+        }
+        return array_view(m_data + offset, count);
+    }
+    /// Return a view of the objects from 'offset' to the end.
+    array_view subview(length_t offset) const
+    {
+        if (offset > m_size) {
+            throw std::out_of_range("subview out of range");
+        }
+        return array_view(m_data + offset, length_t(m_size - offset));
+    }
+    /// Perform a linear search; return the index of the first item for which pred(item, value)
+    /// holds, or size() if there is none.
+    template <typename V, typename Pred>
+    length_t linearSearch(V value, Pred pred) const
+    {
+        return array_algorithms::linear_search(m_data, m_size, value, pred);
+    }
+    /// Perform a linear search for an item equal to 'value'; return its index, or size() if it is
+    /// not found. Vectorized for arithmetic types.
+    length_t linearSearch(const value_type &value) const
+    {
+        return array_algorithms::find(static_cast<const value_type*>(m_data), m_size, value);
+    }
+    /// Perform a binary search; see dynamic_array::binarySearch().
+    template <typename V, typename Pred>
+    length_t binarySearch(V value, Pred pred) const
+    {
+        return array_algorithms::binary_search(m_data, m_size, value, pred);
+    }
+    /// Perform a binary search on items sorted by operator<; see dynamic_array::binarySearch().
+    length_t binarySearch(const value_type &value) const
+    {
+        return array_algorithms::binary_search(static_cast<const value_type*>(m_data), m_size, value);
+    }
+    /// Return the number of items equal to 'value'. Vectorized for arithmetic types.
+    length_t count(const value_type &value) const
+    {
+        return array_algorithms::count(static_cast<const value_type*>(m_data), m_size, value);
+    }
+    /// Return the index of the first minimum item (by operator<), or size() if the view is empty.
+    length_t min_index() const
+    {
+        return array_algorithms::min_index(static_cast<const value_type*>(m_data), m_size);
+    }
+    /// Return the index of the first maximum item (by operator<), or size() if the view is empty.
+    length_t max_index() const
+    {
+        return array_algorithms::max_index(static_cast<const value_type*>(m_data), m_size);
+    }
+protected:
+    /// Check an index is within range
+    void check_index(length_t index) const
+    {
+        if (index >= m_size) {
+            throw std::out_of_range("index out of range");
+        }
+    }
+private:
+    T *m_data;
+    length_t m_size;
+};
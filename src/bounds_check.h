@@ -0,0 +1,35 @@
+#pragma once
+
+/**
+ * \brief Bounds-check policies of dynamic_array, deciding whether operator[], first(), last(),
+ * last_index(), shift_remove() and swap_remove() check their index against the size (throwing
+ * std::out_of_range if it is not within the array):
+ *
+ *     dynamic_array<float, unsigned int, aligned_allocator<float>, doubling_growth, no_stats,
+ *                   bounds_checked_in_debug> samples;
+ *
+ * A policy is a type with a compile-time flag 'enabled'. An unchecked operator[] is a plain load,
+ * with no branch and no throwing call, so loops over it can be inlined and vectorized like loops
+ * over a raw pointer; at_unchecked() offers the same access on a checked array, for a single hot
+ * loop.
+ */
+
+/// Always check indices (the default).
+struct bounds_checked {
+    static const bool enabled = true;
+};
+
+/// Check indices only in DEBUG builds (see CMakeLists.txt), in which the other builds' undefined
+/// behaviour turns into exceptions.
+struct bounds_checked_in_debug {
+#ifdef DEBUG
+    static const bool enabled = true;
+#else
+    static const bool enabled = false;
+#endif
+};
+
+/// Never check indices; an index out of range is undefined behaviour.
+struct bounds_unchecked {
+    static const bool enabled = false;
+};
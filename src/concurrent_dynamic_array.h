@@ -0,0 +1,285 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "aligned_allocator.h"
+#include "dynamic_array.h"
+
+/**
+ * \brief An append-only array supporting concurrent emplace_back() from many threads.
+ *
+ * Items are stored in segments ("buckets") whose sizes are successive powers of two, starting
+ * from 2^B items: bucket k holds 2^(B+k) items, so the array never relocates an item and
+ * references to items stay valid until the array is cleared or destroyed. Finding the bucket of
+ * an index takes a couple of bit operations.
+ *
+ * Concurrency guarantees:
+ *  - emplace_back() claims an index with a single fetch_add and constructs the item in place;
+ *    it never waits for other threads (only the allocator may block). The thread appending the
+ *    middle item of bucket k allocates bucket k + 1 ahead of time, after publishing its item, so
+ *    the threads reaching bucket k + 1 normally find it ready. A thread reaching a bucket not
+ *    published yet allocates one itself and publishes it with one compare-and-swap; a thread
+ *    losing that race frees its own copy and uses the winner's, so there are no retry loops.
+ *    Duplicate allocations thus only happen if half a bucket fills up before the next one is
+ *    allocated.
+ *  - An item becomes visible to other threads when it is published (its ready flag is set with
+ *    release semantics, right after construction). is_published(i) checks this with acquire
+ *    semantics; once it returns true, or once emplace_back() returning i happens-before the read
+ *    by other means (e.g. joining the producer thread), (*this)[i] is safe to read concurrently
+ *    with further appends.
+ *  - size() returns the number of claimed indices, which may include items still being
+ *    constructed by other threads.
+ *  - clear(), flatten() and the destructor must not run concurrently with any other member
+ *    function.
+ */
+
+template <typename T, typename L = unsigned int, unsigned int B = 5>
+class concurrent_dynamic_array {
+    static const std::size_t bits = sizeof(L) * 8;
+    static_assert(B < bits, "the first bucket must be smaller than the maximum size");
+public:
+    using length_t = L;
+
+    /// Number of items in the first bucket.
+    static constexpr std::size_t first_bucket_size = std::size_t(1) << B;
+    /// Number of buckets covering every index representable by length_t.
+    static constexpr std::size_t bucket_count = bits - B + 1;
+
+    /// Default constructor; no memory is allocated until the first append.
+    concurrent_dynamic_array()
+        : m_size(0)
+    {
+        for (std::size_t k = 0; k < bucket_count; k++) {
+            m_buckets[k].store(nullptr, std::memory_order_relaxed);
+            m_prepared[k].store(false, std::memory_order_relaxed);
+        }
+    }
+    concurrent_dynamic_array(const concurrent_dynamic_array &) = delete;
+    concurrent_dynamic_array &operator=(const concurrent_dynamic_array &) = delete;
+    /// Destructor
+    ~concurrent_dynamic_array()
+    {
+        clear();
+        for (std::size_t k = 0; k < bucket_count; k++) {
+            release_bucket(k);
+        }
+    }
+    /// Construct an element in-place at the end; safe to call from many threads at once.
+    /// Return the index of the element.
+    template <typename ...Args>
+    length_t emplace_back(Args &&...args)
+    {
+        std::size_t index = m_size.fetch_add(1, std::memory_order_relaxed);
+        if (index > std::size_t(length_t(-1))) {
+            throw std::length_error("concurrent_dynamic_array is full");
+        }
+        std::size_t k, offset;
+        locate(index, k, offset);
+        unsigned char *bucket = acquire_bucket(k);
+        new (items(bucket) + offset) T(std::forward<Args>(args)...);
+        ready(bucket, k)[offset].store(1, std::memory_order_release);
+        if (offset == bucket_size(k) / 2 && k + 1 < bucket_count) {
+            prepare_bucket(k + 1);
+        }
+        return length_t(index);
+    }
+    /// Add an element to the end; safe to call from many threads at once.
+    length_t push_back(T element)
+    {
+        return emplace_back(std::move(element));
+    }
+    /// Return the number of claimed indices (including items possibly still under construction).
+    length_t size() const
+    {
+        std::size_t size = m_size.load(std::memory_order_acquire);
+        return length_t(size < std::size_t(length_t(-1)) ? size : std::size_t(length_t(-1)));
+    }
+    /// Return whether the item at 'index' has been constructed and can be read.
+    bool is_published(length_t index) const
+    {
+        if (index >= size()) {
+            return false;
+        }
+        std::size_t k, offset;
+        locate(index, k, offset);
+        unsigned char *bucket = m_buckets[k].load(std::memory_order_acquire);
+        return bucket && ready(bucket, k)[offset].load(std::memory_order_acquire);
+    }
+    /// Return (a reference to) a published element; throws std::out_of_range if index >= size.
+    T &operator[](length_t index)
+    {
+        return *item(index);
+    }
+    const T &operator[](length_t index) const
+    {
+        return *item(index);
+    }
+    /// Destroy all items, keeping the allocated buckets for reuse. Not thread-safe.
+    void clear()
+    {
+        std::size_t size = m_size.load(std::memory_order_relaxed);
+        for (std::size_t k = 0; k < bucket_count && bucket_start(k) < size; k++) {
+            unsigned char *bucket = m_buckets[k].load(std::memory_order_relaxed);
+            if (!bucket) {
+                continue;
+            }
+            std::size_t count = bucket_size(k);
+            if (size - bucket_start(k) < count) {
+                count = size - bucket_start(k);
+            }
+            for (std::size_t i = 0; i < count; i++) {
+                if (ready(bucket, k)[i].load(std::memory_order_relaxed)) {
+                    items(bucket)[i].~T();
+                    ready(bucket, k)[i].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+        m_size.store(0, std::memory_order_relaxed);
+    }
+    /// Move all the published items, in index order, into a contiguous dynamic_array, leaving this
+    /// array empty (its buckets are kept for reuse). Items whose construction failed are skipped.
+    /// Not thread-safe; call it at the end of the append phase.
+    template <typename A = aligned_allocator<T>>
+    dynamic_array<T, L, A> flatten(const A &alloc = A())
+    {
+        dynamic_array<T, L, A> result(size(), alloc);
+        std::size_t size = m_size.load(std::memory_order_relaxed);
+        for (std::size_t k = 0; k < bucket_count && bucket_start(k) < size; k++) {
+            unsigned char *bucket = m_buckets[k].load(std::memory_order_relaxed);
+            if (!bucket) {
+                continue;
+            }
+            std::size_t count = bucket_size(k);
+            if (size - bucket_start(k) < count) {
+                count = size - bucket_start(k);
+            }
+            move_items(result, bucket, k, count, typename std::is_trivially_copyable<T>::type());
+        }
+        clear();
+        return result;
+    }
+private:
+    /// Find the bucket and the offset within it of an index.
+    static void locate(std::size_t index, std::size_t &k, std::size_t &offset)
+    {
+        std::size_t j = index + first_bucket_size;
+        std::size_t log2 = sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(j);
+        k = log2 - B;
+        offset = j - (std::size_t(1) << log2);
+    }
+    static std::size_t bucket_size(std::size_t k)
+    {
+        return first_bucket_size << k;
+    }
+    static std::size_t bucket_start(std::size_t k)
+    {
+        return bucket_size(k) - first_bucket_size;
+    }
+    /// A bucket is a single block holding its items followed by one ready flag per item.
+    static T *items(unsigned char *bucket)
+    {
+        return reinterpret_cast<T*>(bucket);
+    }
+    static std::atomic<unsigned char> *ready(unsigned char *bucket, std::size_t k)
+    {
+        return reinterpret_cast<std::atomic<unsigned char>*>(bucket + bucket_size(k) * sizeof(T));
+    }
+    static std::size_t bucket_bytes(std::size_t k)
+    {
+        return bucket_size(k) * (sizeof(T) + sizeof(std::atomic<unsigned char>));
+    }
+    /// Return bucket k, allocating it if it has not been published yet.
+    unsigned char *acquire_bucket(std::size_t k)
+    {
+        unsigned char *bucket = m_buckets[k].load(std::memory_order_acquire);
+        return bucket ? bucket : install_bucket(k);
+    }
+    /// Allocate bucket k ahead of time, unless another thread has already set about it; a
+    /// failure is left for the thread reaching the bucket to report.
+    void prepare_bucket(std::size_t k)
+    {
+        if (!m_buckets[k].load(std::memory_order_relaxed) && !m_prepared[k].load(std::memory_order_relaxed) &&
+            !m_prepared[k].exchange(true, std::memory_order_relaxed)) {
+            try {
+                install_bucket(k);
+            }
+            catch (...) {
+            }
+        }
+    }
+    /// Allocate bucket k and publish it with a compare-and-swap, unless another thread has
+    /// published one first (then free this one); return the published bucket.
+    unsigned char *install_bucket(std::size_t k)
+    {
+        unsigned char *fresh = m_allocator.allocate(bucket_bytes(k));
+        for (std::size_t i = 0; i < bucket_size(k); i++) {
+            new (ready(fresh, k) + i) std::atomic<unsigned char>(0);
+        }
+        unsigned char *bucket = nullptr;
+        if (m_buckets[k].compare_exchange_strong(bucket, fresh, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire)) {
+            return fresh;
+        }
+        // Another thread won; 'bucket' now holds its allocation.
+        m_allocator.deallocate(fresh, bucket_bytes(k));
+        return bucket;
+    }
+    void release_bucket(std::size_t k)
+    {
+        unsigned char *bucket = m_buckets[k].load(std::memory_order_relaxed);
+        if (bucket) {
+            m_allocator.deallocate(bucket, bucket_bytes(k));
+        }
+    }
+    T *item(length_t index) const
+    {
+        if (index >= size()) {
+            throw std::out_of_range("index out of range");
+        }
+        std::size_t k, offset;
+        locate(index, k, offset);
+        return items(m_buckets[k].load(std::memory_order_acquire)) + offset;
+    }
+    /// flatten() helpers: for trivially copyable types, append the leading run of published items of
+    /// a bucket with a single copy, then move the rest of the published items one by one.
+    template <typename Array>
+    static void move_items(Array &result, unsigned char *bucket, std::size_t k, std::size_t count,
+                           std::true_type)
+    {
+        std::size_t complete = 0;
+        while (complete < count && ready(bucket, k)[complete].load(std::memory_order_relaxed)) {
+            complete++;
+        }
+        result.append(items(bucket), length_t(complete));
+        move_items(result, bucket, k, complete, count);
+    }
+    template <typename Array>
+    static void move_items(Array &result, unsigned char *bucket, std::size_t k, std::size_t count,
+                           std::false_type)
+    {
+        move_items(result, bucket, k, 0, count);
+    }
+    template <typename Array>
+    static void move_items(Array &result, unsigned char *bucket, std::size_t k, std::size_t first,
+                           std::size_t last)
+    {
+        for (std::size_t i = first; i < last; i++) {
+            if (ready(bucket, k)[i].load(std::memory_order_relaxed)) {
+                result.emplace_back(std::move(items(bucket)[i]));
+            }
+        }
+    }
+
+    std::atomic<std::size_t> m_size;
+    std::atomic<unsigned char*> m_buckets[bucket_count];
+    std::atomic<bool> m_prepared[bucket_count];   // set by the thread allocating a bucket ahead of time
+    aligned_allocator<unsigned char, alignof(T)> m_allocator;
+};
+
+template <typename T, typename L, unsigned int B>
+constexpr std::size_t concurrent_dynamic_array<T, L, B>::first_bucket_size;
+template <typename T, typename L, unsigned int B>
+constexpr std::size_t concurrent_dynamic_array<T, L, B>::bucket_count;
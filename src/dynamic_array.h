@@ -1,6 +1,17 @@
 #pragma once
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 #include <stdexcept>
+#include "aligned_allocator.h"
+#include "array_algorithms.h"
+#include "array_view.h"
+#include "array_stats.h"
+#include "bounds_check.h"
+#include "growth_policy.h"
+#include "parallel_algorithms.h"
 
 /**
  * \brief A template class to handle a continuous dynamic (extendable) range of objects.
@@ -17,114 +28,373 @@
  *  - It must have a well-defined assignment operator, so that the uninitialized objects can be
  *    initialized as copies of other objects.
  *
- * It grows automatically when required, by doubling its capacity. Moreover, an element in the
+ * It grows automatically when required, by doubling its capacity; a different growth policy G
+ * (see growth_policy.h) can be specified, e.g. geometric_growth<> for 1.5x growth, or
+ * shrinking_growth<> to also release memory as items are deleted. Moreover, an element in the
  * middle of the array can be removed by copying (copy-assignment) the last one on top of it and
  * reducing the size by one. However, this changes the order of the objects.
  *
- * For debug purposes, we have added an additional m_dbgPtr* pointer which can be used by
- * a debugger to inspect the m_storage array as an actual array of T.
+ * Growing gives the strong exception guarantee: the items are moved into the new buffer if their
+ * move constructor is noexcept and copied otherwise (std::move_if_noexcept), so that if a
+ * constructor throws, the array is left as it was. Without a noexcept move constructor, large
+ * items are copied on every growth; declaring it noexcept (or the type trivially relocatable)
+ * avoids that.
+ *
+ * For trivially relocatable types (see is_trivially_relocatable) growing and removing elements
+ * moves raw bytes with memcpy/memmove instead of move-constructing and destroying each object.
+ * If the allocator can resize blocks (see allocator_has_reallocate), such as the default
+ * aligned_allocator through realloc, growing first tries that, so that large buffers can be
+ * extended in place instead of being copied while both the old and the new one are held.
+ *
+ * The storage buffer is obtained from an allocator of type A, which is rebound to T and must use
+ * plain T* pointers. The default aligned_allocator<T> honours alignof(T), so over-aligned types
+ * are stored correctly; aligned_dynamic_array<T, N> additionally aligns data() to N bytes (e.g. 64
+ * for cache lines or AVX-512 loads). The allocator only provides raw memory;
+ * the objects themselves are constructed with placement new and destroyed directly. It follows
+ * the std::allocator_traits propagation rules, like the standard containers do:
+ *  - Copy-construction uses select_on_container_copy_construction() of the source's allocator.
+ *  - Move-construction moves the allocator along with the storage, so it never copies elements.
+ *  - Copy-assignment adopts the source's allocator only if propagate_on_container_copy_assignment
+ *    holds; otherwise the copy is made with the destination's own allocator.
+ *  - Move-assignment steals the storage if propagate_on_container_move_assignment holds or the
+ *    two allocators compare equal; otherwise the elements are moved one by one into storage of
+ *    the destination's allocator (e.g. between two different arenas).
+ *  - swap() exchanges the allocators only if propagate_on_container_swap holds; swapping arrays
+ *    whose allocators do not propagate and do not compare equal is undefined.
+ *
+ * The statistics policy S (see array_stats.h) is told about every allocation, growth, relocation
+ * and copy; the default no_stats records nothing and costs nothing, while site_stats<Tag> adds the
+ * events to the global totals of a call site.
+ *
+ * The bounds-check policy B (see bounds_check.h) decides whether indices are checked: always (the
+ * default bounds_checked), only in DEBUG builds, or never. The array's own loops never check.
  */
 
-template <typename T, typename L = unsigned int>
+template <typename T, typename L, typename A, typename G, typename S, typename B>
+class frozen_array;
+
+template <typename T, typename L = unsigned int, typename A = aligned_allocator<T>,
+          typename G = doubling_growth, typename S = no_stats, typename B = bounds_checked>
 class dynamic_array {
+    using alloc_traits = typename std::allocator_traits<A>::template rebind_traits<T>;
 public:
     using length_t = L;
+    using allocator_type = typename alloc_traits::allocator_type;
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using growth_policy = G;
+    using stats_policy = S;
+    using bounds_check_policy = B;
 
     /// Default constructor.
     dynamic_array()
         : dynamic_array(0)
     {}
+    /// Construct an empty array using a specific allocator.
+    explicit dynamic_array(const allocator_type &alloc)
+        : dynamic_array(0, alloc)
+    {}
     /// Construct with an initial capacity.
-    dynamic_array(length_t capacity)
-        : m_capacity(capacity), m_size(0), m_storage(nullptr)
+    dynamic_array(length_t capacity, const allocator_type &alloc = allocator_type())
+        : m_capacity(capacity), m_size(0), m_storage(nullptr), m_allocator(alloc)
     {
         allocate(capacity);
     }
     /// Construct with an initial amount of copies (size = capacity)
-    dynamic_array(length_t count, const T &val)
-        : dynamic_array(count)
+    dynamic_array(length_t count, const T &val, const allocator_type &alloc = allocator_type())
+        : dynamic_array(count, alloc)
     {
-        for (length_t i = 0; i < m_size; i++) {
-            push_back(val);
-        }
+        array_algorithms::uninitialized_fill(m_storage, val, count);
+        stats_policy::on_copy(count);
+        m_size = count;
+        stats_policy::on_size(m_size);
     }
     /// Copy-constructor; performs a copy of the array.
-    dynamic_array(const dynamic_array<T> &other)
-        : dynamic_array(other.m_capacity)
+    dynamic_array(const dynamic_array &other)
+        : dynamic_array(other, alloc_traits::select_on_container_copy_construction(other.m_allocator))
+    {}
+    /// Copy-constructor using a specific allocator for the copy; the copy's capacity is the size
+    /// of the array, and its items are copied in bulk (with a single memcpy for trivially copyable
+    /// types).
+    dynamic_array(const dynamic_array &other, const allocator_type &alloc)
+        : dynamic_array(other.m_size, alloc)
     {
-        for (int i = 0; i < other.m_size; i++) {
-            push_back(other[i]);
-        }
+        array_algorithms::uninitialized_copy(m_storage, other.m_storage, other.m_size);
+        stats_policy::on_copy(other.m_size);
+        m_size = other.m_size;
+        stats_policy::on_size(m_size);
     }
-    /// Move-constructor; move contents of another array.
-    dynamic_array(dynamic_array<T> &&other)
-        : dynamic_array()
+    /// Move-constructor; move contents (and the allocator) of another array.
+    dynamic_array(dynamic_array &&other) noexcept
+        : dynamic_array(std::move(other.m_allocator))
     {
-        swap(*this, other);
+        swap_storage(other);
     }
-    /// unified-assignment operator
-    dynamic_array<T> &operator=(dynamic_array<T> other)
+    /// Copy-assignment operator; see the class documentation for the allocator semantics.
+    /// Trivially copyable items are copied into the current buffer if it is large enough (and
+    /// the allocator is kept), which cannot fail; otherwise the copy is made into a new buffer of
+    /// the size of the array, so that if a copy throws, the array is left as it was.
+    dynamic_array &operator=(const dynamic_array &other)
     {
-        swap(*this, other);
+        if (this == &other) {
+            return *this;
+        }
+        if (std::is_trivially_copyable<T>::value && other.m_size <= m_capacity &&
+            (!propagate_on_copy::value || m_allocator == other.m_allocator)) {
+            array_algorithms::uninitialized_copy(m_storage, other.m_storage, other.m_size);
+            stats_policy::on_copy(other.m_size);
+            m_size = other.m_size;
+            stats_policy::on_size(m_size);
+        }
+        else {
+            dynamic_array temp(other, propagate_on_copy::value ? other.m_allocator : m_allocator);
+            swap_storage(temp);
+            swap_allocator(temp, propagate_on_copy());
+        }
+        return *this;
+    }
+    /// Move-assignment operator; see the class documentation for the allocator semantics.
+    dynamic_array &operator=(dynamic_array &&other)
+    {
+        if (propagate_on_move::value || m_allocator == other.m_allocator) {
+            dynamic_array temp(std::move(other));
+            swap_storage(temp);
+            swap_allocator(temp, propagate_on_move());
+        }
+        else {
+            // Storage cannot change hands; move the elements into storage of our own allocator.
+            dynamic_array temp(other.m_size, m_allocator);
+            stats_policy::on_relocate(other.m_size, other.m_size * sizeof(T), false);
+            for (length_t i = 0; i < other.m_size; i++) {
+                temp.push_back(std::move(other.m_storage[i]));
+            }
+            other.clear();
+            swap_storage(temp);
+        }
         return *this;
     }
     /// Destructor
     ~dynamic_array()
     { free(); }
     /// Swap two dynamic arrays
-    friend void swap(dynamic_array<T> &first, dynamic_array<T> &second)
+    friend void swap(dynamic_array &first, dynamic_array &second)
     {
-        using std::swap;
-        swap(first.m_capacity, second.m_capacity);
-        swap(first.m_size, second.m_size);
-        swap(first.m_storage, second.m_storage);
+        first.swap_storage(second);
+        first.swap_allocator(second, typename alloc_traits::propagate_on_container_swap());
     }
-    /// Add an element to the end.
-    ///
-    /// Pass by value to handle the case when we are copying from the same array and the
-    /// potential grow() operation might invalidate the element to push_back().
-    void push_back(T element)
+    /// Return a copy of the allocator used by the array.
+    allocator_type get_allocator() const
     {
-        // If size plus one exceeds capacity, grow the array by doubling capacity
-        if ((m_size + 1) > m_capacity) {
-            grow(m_capacity ? 2 * m_capacity : 1);
-        }
-        new (m_storage + m_size++ * sizeof(T)) T(std::move(element));
+        return m_allocator;
+    }
+    /// Add a copy of an element to the end; the element may be an item of the array itself.
+    void push_back(const T &element)
+    {
+        emplace_back(element);
+    }
+    /// Add an element to the end by moving it into place.
+    void push_back(T &&element)
+    {
+        emplace_back(std::move(element));
     }
     /// Construct an element in-place at the end.
     /// Return reference to the element.
+    ///
+    /// The arguments may refer to items of the array itself: when the array has to grow, the
+    /// element is constructed before growing, and moved into place afterwards.
     template <typename ...Args>
     T &emplace_back(Args &&...args)
     {
-        // If size plus one exceeds capacity, grow the array by doubling capacity
         if ((m_size + 1) > m_capacity) {
-            grow(m_capacity ? 2 * m_capacity : 1);
+            return emplace_back_grow(std::forward<Args>(args)...);
+        }
+        new (m_storage + m_size) T(std::forward<Args>(args)...);
+        stats_policy::on_size(++m_size);
+        return m_storage[m_size - 1];
+    }
+    /// Append 'count' items constructed in place from factory(i), for i from 0 to count - 1,
+    /// growing at most once; a factory returning the item by value (e.g. a lambda) has it
+    /// constructed directly in the array, without a move when the compiler elides it (always from
+    /// C++17). If a call throws, the items appended so far are destroyed and the size is restored
+    /// (the capacity may have grown).
+    ///
+    ///     points.emplace_back_n(n, [&](unsigned int i) { return point(xs[i], ys[i]); });
+    template <typename Factory>
+    void emplace_back_n(length_t count, Factory factory)
+    {
+        if (m_size + count > m_capacity) {
+            grow(growth_policy::template next_capacity<T>(m_capacity, length_t(m_size + count)));
+        }
+        length_t size = m_size;
+        try {
+            for (length_t i = 0; i < count; i++) {
+                new (m_storage + m_size) T(factory(i));
+                m_size++;
+            }
+        }
+        catch (...) {
+            while (m_size > size) {
+                remove(--m_size);
+            }
+            throw;
+        }
+        stats_policy::on_size(m_size);
+    }
+    /// Append 'count' items constructed in place from generator() (like std::generate_n), growing
+    /// at most once; see emplace_back_n().
+    template <typename Generator>
+    void append_generate(length_t count, Generator generator)
+    {
+        emplace_back_n(count, [&generator](length_t) { return generator(); });
+    }
+    /// Make sure the array can hold at least 'capacity' items without growing.
+    void reserve(length_t capacity)
+    {
+        if (capacity > m_capacity) {
+            grow(capacity);
         }
-        new (m_storage + m_size++ * sizeof(T)) T(std::forward<Args>(args)...);
-        return last();
+    }
+    /// Reduce the capacity to the size, releasing the buffer of an empty array. For trivially
+    /// relocatable items and an allocator that can resize blocks this shrinks the block in place.
+    void shrink_to_fit()
+    {
+        if (m_capacity > m_size) {
+            shrink(m_size);
+        }
+    }
+    /// Append copies of 'count' items starting at 'items', with a single capacity check and a
+    /// single memcpy for trivially copyable types. The items may belong to the array itself.
+    void append(const T *items, length_t count)
+    {
+        if (m_size + count > m_capacity) {
+            // The source might be moved by grow() if it lies within the array.
+            bool inside = items >= m_storage && items < m_storage + m_size;
+            std::ptrdiff_t offset = inside ? items - m_storage : 0;
+            grow(growth_policy::template next_capacity<T>(m_capacity, length_t(m_size + count)));
+            if (inside) {
+                items = m_storage + offset;
+            }
+        }
+        array_algorithms::uninitialized_copy(m_storage + m_size, items, count);
+        stats_policy::on_copy(count);
+        m_size += count;
+        stats_policy::on_size(m_size);
+    }
+    /// Append copies of the items in the range [first, last) of a contiguous buffer.
+    void append(const T *first, const T *last)
+    {
+        append(first, length_t(last - first));
+    }
+    void append(T *first, T *last)
+    {
+        append(static_cast<const T*>(first), length_t(last - first));
+    }
+    /// Append copies of the items in the range [first, last); for forward iterators the capacity
+    /// is checked once. The range must not refer to items of the array itself.
+    template <typename Iterator>
+    void append(Iterator first, Iterator last)
+    {
+        append(first, last, typename std::iterator_traits<Iterator>::iterator_category());
+    }
+    /// Resize the array, default-initializing the new items; for trivial types (PODs) this leaves
+    /// their values indeterminate instead of zero-filling them.
+    void resize_default_init(length_t size)
+    {
+        reserve(size);
+        while (m_size < size) {
+            new (m_storage + m_size) T;
+            m_size++;
+        }
+        stats_policy::on_size(m_size);
+        while (m_size > size) {
+            pop_back();
+        }
+    }
+    /// Resize an array of trivial items without initializing the new ones, e.g. right before
+    /// overwriting them through data().
+    void resize_uninitialized(length_t size)
+    {
+        static_assert(std::is_trivial<T>::value, "resize_uninitialized() requires a trivial type");
+        reserve(size);
+        m_size = size;
+        stats_policy::on_size(m_size);
     }
     /// Delete the last element.
     void pop_back()
     {
         remove(--m_size);
+        auto_shrink();
+    }
+    /// Insert an element at position 'index' (at most size()) by shifting forward all items from
+    /// there on; throws std::out_of_range if index > size.
+    void shift_insert(length_t index, T value)
+    {
+        if (index > m_size) {
+            throw std::out_of_range("index out of range");
+        }
+        if ((m_size + 1) > m_capacity) {
+            grow(growth_policy::template next_capacity<T>(m_capacity, length_t(m_size + 1)));
+        }
+        array_algorithms::shift_insert(m_storage, m_size, index, std::move(value));
+        stats_policy::on_size(++m_size);
     }
     /// Delete an element by shifting back all items next to it.
     void shift_remove(int index)
     {
-        assert(index);
-        for (int i = index + 1; i < m_size; i++) {
-            (*this)[i - 1] = std::move((*this)[i]);
-        }
-        pop_back();
+        check_index(length_t(index));
+        array_algorithms::shift_remove(m_storage, m_size, length_t(index));
+        m_size--;
+        auto_shrink();
     }
     /// Delete an element by moving the last one on top of it.
     void swap_remove(int index)
     {
-        assert(index);
-        if (index < m_size - 1) {
-            swap((*this)[index], last());
+        check_index(length_t(index));
+        array_algorithms::swap_remove(m_storage, m_size, length_t(index));
+        m_size--;
+        auto_shrink();
+    }
+    /// Delete all the items for which pred(item) holds, keeping the order of the others, in a
+    /// single pass. Return the number of items deleted.
+    template <typename Pred>
+    length_t remove_if(Pred pred)
+    {
+        length_t size = m_size;
+        m_size = array_algorithms::remove_if(m_storage, m_size, pred);
+        auto_shrink();
+        return size - m_size;
+    }
+    /// Delete all the items for which pred(item) holds by moving items from the end into the
+    /// holes; faster than remove_if(), but changes the order of the objects. Return the number
+    /// of items deleted.
+    template <typename Pred>
+    length_t swap_remove_if(Pred pred)
+    {
+        length_t size = m_size;
+        m_size = array_algorithms::swap_remove_if(m_storage, m_size, pred);
+        auto_shrink();
+        return size - m_size;
+    }
+    /// Delete the items in the index range [first, last), shifting back the items next to them
+    /// once; throws std::out_of_range if the range does not lie within the array.
+    void erase(length_t first, length_t last)
+    {
+        if (first > last || last > m_size) {
+            throw std::out_of_range("index out of range");
+        }
+        m_size = array_algorithms::erase(m_storage, m_size, first, last);
+        auto_shrink();
+    }
+    /// Delete the items at 'count' indices sorted in ascending order, in a single pass; throws
+    /// std::out_of_range (deleting nothing) if an index is not within the array.
+    void erase_indices(const length_t *indices, length_t count)
+    {
+        if (count && indices[count - 1] >= m_size) {
+            throw std::out_of_range("index out of range");
         }
-        pop_back();
+        m_size = array_algorithms::erase_indices(m_storage, m_size, indices, count);
+        auto_shrink();
     }
     /// Return the size of the array (number of items contained).
     length_t size() const
@@ -136,17 +406,34 @@ public:
     {
         return m_capacity;
     }
-    /// Return (a reference to) the element at position 'index'; throws std::out_of_range if index >= size.
+    /// Return (a reference to) the element at position 'index'; throws std::out_of_range if index >= size,
+    /// unless the bounds-check policy disables the check.
     T& operator[](length_t index)
     {
-        assert(index);
-        return *reinterpret_cast<T*>(m_storage + (index * sizeof(T)));
+        check_index(index);
+        return m_storage[index];
     }
     /// The const-version of the above; implemented so that we can work with const dynamic_array objects.
     const T& operator[](length_t index) const
     {
-        assert(index);
-        return *reinterpret_cast<T*>(m_storage + (index * sizeof(T)));
+        check_index(index);
+        return m_storage[index];
+    }
+    /// Return (a reference to) the element at position 'index' without checking the index, e.g.
+    /// in inner loops that the compiler should vectorize; checked only in DEBUG builds.
+    T& at_unchecked(length_t index)
+    {
+#ifdef DEBUG
+        check_index(index, std::true_type());
+#endif
+        return m_storage[index];
+    }
+    const T& at_unchecked(length_t index) const
+    {
+#ifdef DEBUG
+        check_index(index, std::true_type());
+#endif
+        return m_storage[index];
     }
     /// Return the first item.
     T& first() { return (*this)[0]; }
@@ -157,103 +444,335 @@ public:
     /// Return raw (read-only) access to data
     const T *data() const
     {
-        return reinterpret_cast<const T*>(m_storage);
+        return m_storage;
     }
     /// Return raw access to data
     T *data()
     {
-        return reinterpret_cast<T*>(m_storage);
+        return m_storage;
     }
+    /// Return iterators (raw pointers) to the beginning and the end of the items, to use the array
+    /// with range-for loops and the standard algorithms; growing the array invalidates them.
+    iterator begin() { return m_storage; }
+    iterator end() { return m_storage + m_size; }
+    const_iterator begin() const { return m_storage; }
+    const_iterator end() const { return m_storage + m_size; }
+    const_iterator cbegin() const { return m_storage; }
+    const_iterator cend() const { return m_storage + m_size; }
     /// Return the last valid index.
     length_t last_index() const
     {
-        assert(m_size - 1);
+        check_index(m_size - 1);
         return m_size - 1;
     }
-    /// Clear the array by destroying all items.
+    /// Clear the array by destroying all items; the capacity is kept, unless the growth policy
+    /// shrinks arrays.
     void clear()
     {
         for (length_t i = 0; i < m_size; i++) {
             remove(i);
         }
         m_size = 0;
+        auto_shrink();
+    }
+    /// Return a view of all the items.
+    array_view<T, L> view()
+    {
+        return array_view<T, L>(data(), m_size);
+    }
+    array_view<const T, L> view() const
+    {
+        return array_view<const T, L>(data(), m_size);
+    }
+    /// Convert to a view of all the items, e.g. to pass the array to a function taking a view.
+    operator array_view<T, L>()
+    {
+        return view();
+    }
+    operator array_view<const T, L>() const
+    {
+        return view();
+    }
+    /// Return an immutable snapshot of the items that is copied in O(1) (see frozen_array.h,
+    /// which defines these): a copy of the items, or for an rvalue array (e.g.
+    /// std::move(array).freeze()) the items themselves, leaving the array empty.
+    frozen_array<T, L, A, G, S, B> freeze() const &;
+    frozen_array<T, L, A, G, S, B> freeze() &&;
+    /// Sort the items by operator<, with a radix sort for integers and floats; with 'threads' other
+    /// than 1 (0 for all the hardware threads), large arrays are sorted by several threads.
+    void sort(unsigned int threads = 1)
+    {
+        if (threads == 1) {
+            array_algorithms::sort(m_storage, m_size);
+        }
+        else {
+            parallel_algorithms::sort(begin(), end(), std::less<T>(), threads);
+        }
+    }
+    /// Sort the items by comp(a, b) (true if a is ordered before b), with std::sort; see above
+    /// for 'threads'.
+    template <typename Compare, typename = typename std::enable_if<!std::is_arithmetic<Compare>::value>::type>
+    void sort(Compare comp, unsigned int threads = 1)
+    {
+        if (threads == 1) {
+            std::sort(begin(), end(), comp);
+        }
+        else {
+            parallel_algorithms::sort(begin(), end(), comp, threads);
+        }
+    }
+    /// Insert an item into an array sorted by operator<, after the items equal to it, shifting
+    /// forward the items ordered after it once. Return the index of the item.
+    length_t insert_sorted(T value)
+    {
+        length_t index = array_algorithms::lower_bound(m_storage, m_size, value,
+                                                       [](const T &item, const T &v) { return !(v < item); });
+        shift_insert(index, std::move(value));
+        return index;
+    }
+    /// Merge copies of items sorted by operator< into an array sorted by operator<, in a single
+    /// pass from the back, instead of appending and sorting again; equal items keep their order,
+    /// with the ones already in the array first. The items must not belong to the array.
+    void merge_sorted(array_view<const T, L> items)
+    {
+        if (m_size + items.size() > m_capacity) {
+            grow(growth_policy::template next_capacity<T>(m_capacity, length_t(m_size + items.size())));
+        }
+        array_algorithms::merge_into(m_storage, m_size, items.data(), items.size(), std::less<T>());
+        stats_policy::on_copy(items.size());
+        m_size += items.size();
+        stats_policy::on_size(m_size);
     }
     /// Perform a linear search for a specific item (operator '==' must be defined for class T)
     template <typename V, typename Pred>
     length_t linearSearch(V value, Pred pred) const
     {
-        length_t i = 0;
-        while(i < size() && !(pred((*this)[i], value))) { i++; }
-        return i;
+        return view().linearSearch(value, pred);
     }
-    /// Perform a binary search on the items
+    /// Perform a linear search for an item equal to 'value'; return its index, or size() if it is
+    /// not found. Vectorized for arithmetic types.
+    length_t linearSearch(const T &value) const
+    {
+        return view().linearSearch(value);
+    }
+    /// Perform a binary search on the items; pred(item, value) returns a negative number if the
+    /// item is ordered before the value. Return the index of the first item not ordered before
+    /// the value, or the last index if there is none (0 for an empty array).
     template <typename V, typename Pred>
     length_t binarySearch(V value, Pred pred) const
     {
-        int imin = 0;
-        int imax = this->last_index();
-        int imid;
-        while (imin < imax) {
-            imid = (imin + imax)/2;
-            if (imin >= imax) {
-                break;
-            }
-            if (pred((*this)[imid], value) < 0) {
-                imin = imid + 1;
-            }
-            else{
-                imax = imid;
-            }
-        }
-        return imin;
+        return view().binarySearch(value, pred);
+    }
+    /// Perform a binary search on items sorted by operator<; same result as the above.
+    length_t binarySearch(const T &value) const
+    {
+        return view().binarySearch(value);
+    }
+    /// Return the number of items equal to 'value'. Vectorized for arithmetic types.
+    length_t count(const T &value) const
+    {
+        return view().count(value);
+    }
+    /// Return the index of the first minimum item (by operator<), or size() if the array is empty.
+    length_t min_index() const
+    {
+        return view().min_index();
+    }
+    /// Return the index of the first maximum item (by operator<), or size() if the array is empty.
+    length_t max_index() const
+    {
+        return view().max_index();
     }
 protected:
+    using propagate_on_copy = typename alloc_traits::propagate_on_container_copy_assignment;
+    using propagate_on_move = typename alloc_traits::propagate_on_container_move_assignment;
+
     // Helper functions.
-    /// Assert an index is within range
-    inline void assert(length_t index) const {
+    /// Check an index is within range, if the bounds-check policy says so.
+    void check_index(length_t index) const
+    {
+        check_index(index, std::integral_constant<bool, bounds_check_policy::enabled>());
+    }
+    void check_index(length_t index, std::true_type) const
+    {
         if (index >= m_size) {
             throw std::out_of_range("index out of range");
         }
     }
+    void check_index(length_t, std::false_type) const
+    {}
+    /// emplace_back() into a full array: construct the element first, since the arguments may refer
+    /// to items that growing moves, then move it into the grown buffer.
+    template <typename ...Args>
+    T &emplace_back_grow(Args &&...args)
+    {
+        T element(std::forward<Args>(args)...);
+        grow(growth_policy::template next_capacity<T>(m_capacity, length_t(m_size + 1)));
+        new (m_storage + m_size) T(std::move(element));
+        stats_policy::on_size(++m_size);
+        return m_storage[m_size - 1];
+    }
     /// Grow into a new capacity (assumes capacity >= m_capacity)
     void grow(length_t capacity)
     {
-        char *newStorage = new char[capacity * sizeof(T)];
-        // Move-construct the currently holded elements there.
-        for (int i = 0; i < m_size; i++) {
-            new (newStorage + i * sizeof(T)) T(std::move((*this)[i]));
+        length_t old_capacity = m_capacity;
+        move_storage(capacity, can_reallocate());
+        stats_policy::on_grow(old_capacity, capacity, m_size);
+    }
+    /// Shrink into a smaller capacity (assumes m_size <= capacity < m_capacity); a zero capacity
+    /// releases the buffer.
+    void shrink(length_t capacity)
+    {
+        length_t old_capacity = m_capacity;
+        if (capacity) {
+            move_storage(capacity, can_reallocate());
+        }
+        else {
+            deallocate();
+            m_storage = nullptr;
+            m_capacity = 0;
+        }
+        stats_policy::on_shrink(old_capacity, capacity, m_size);
+    }
+    /// Shrink as the growth policy dictates, if it ever shrinks arrays, after deleting items.
+    void auto_shrink()
+    {
+        auto_shrink(growth_policy_shrinks<growth_policy>());
+    }
+    void auto_shrink(std::true_type)
+    {
+        length_t capacity = growth_policy::template shrink_capacity<T>(m_capacity, m_size);
+        if (capacity < m_capacity) {
+            try {
+                shrink(capacity);
+            }
+            catch (const std::bad_alloc &) {
+                // Shrinking is only an optimization; keep the current buffer.
+            }
+        }
+    }
+    void auto_shrink(std::false_type)
+    {}
+    /// Items that are trivially relocatable can be moved by the allocator along with the block.
+    using can_reallocate = std::integral_constant<bool, is_trivially_relocatable<T>::value &&
+                                                        allocator_has_reallocate<allocator_type>::value>;
+    /// Move into a buffer of a new capacity by resizing the buffer through the allocator, possibly
+    /// in place; fall back to a new buffer if the allocator cannot resize it.
+    void move_storage(length_t capacity, std::true_type)
+    {
+        if (m_storage) {
+            T *newStorage = m_allocator.reallocate(m_storage, m_capacity, capacity);
+            if (newStorage) {
+                stats_policy::on_allocate(capacity * sizeof(T));
+                stats_policy::on_deallocate(m_capacity * sizeof(T));
+                m_storage = newStorage;
+                m_capacity = capacity;
+                return;
+            }
+        }
+        move_storage(capacity, std::false_type());
+    }
+    /// Move into a buffer of a new capacity by relocating the items into a new buffer; if that
+    /// throws, the new buffer is released and the array keeps its items.
+    void move_storage(length_t capacity, std::false_type)
+    {
+        T *newStorage = alloc_traits::allocate(m_allocator, capacity);
+        // Relocate the currently holded elements there.
+        try {
+            array_algorithms::relocate(newStorage, m_storage, m_size);
         }
-        // Delete the old array.
-        free();
+        catch (...) {
+            alloc_traits::deallocate(m_allocator, newStorage, capacity);
+            throw;
+        }
+        stats_policy::on_allocate(capacity * sizeof(T));
+        stats_policy::on_relocate(m_size, m_size * sizeof(T), is_trivially_relocatable<T>::value);
+        // Delete the old array; its elements have already been destroyed by relocate().
+        deallocate();
         // Replace the pointer.
         m_storage = newStorage;
         m_capacity = capacity;
     }
+    /// append() for forward iterators: grow once, then copy-construct in place.
+    template <typename Iterator>
+    void append(Iterator first, Iterator last, std::forward_iterator_tag)
+    {
+        length_t count = length_t(std::distance(first, last));
+        if (m_size + count > m_capacity) {
+            grow(growth_policy::template next_capacity<T>(m_capacity, length_t(m_size + count)));
+        }
+        stats_policy::on_copy(count);
+        for (; first != last; ++first) {
+            new (m_storage + m_size) T(*first);
+            m_size++;
+        }
+        stats_policy::on_size(m_size);
+    }
+    /// append() for input iterators, whose length is not known in advance.
+    template <typename Iterator>
+    void append(Iterator first, Iterator last, std::input_iterator_tag)
+    {
+        for (; first != last; ++first) {
+            emplace_back(*first);
+            stats_policy::on_copy(1);
+        }
+    }
     /// Destroy a value at a specific position.
     void remove(length_t index)
     {
         // explicitly call destructor of T to destroy object at index
-        T *ptr = reinterpret_cast<T*>(m_storage + index * sizeof(T));
-        ptr->~T();
+        m_storage[index].~T();
     }
-    /// Allocate the storage buffer to hold specified number of items.
+    /// Allocate the storage buffer to hold specified number of items (nothing for zero items).
     void allocate(length_t size)
     {
-        m_storage = new char[size * sizeof(T)];
+        m_storage = size ? alloc_traits::allocate(m_allocator, size) : nullptr;
+        if (size) {
+            stats_policy::on_allocate(size * sizeof(T));
+        }
+    }
+    /// Return the buffer to the allocator, without destroying any objects.
+    void deallocate()
+    {
+        if (m_storage) {
+            alloc_traits::deallocate(m_allocator, m_storage, m_capacity);
+            stats_policy::on_deallocate(m_capacity * sizeof(T));
+        }
     }
     /// Free the buffer.
     void free()
     {
         if (m_storage) {
+            stats_policy::on_release(m_size, m_capacity);
             // before freeing up memory we have to explicitly destroy any objects contained inside
             for (length_t i = 0; i < m_size; i++) { remove(i); }
             // now we can free up the memory
-            delete[] m_storage;
+            deallocate();
         }
     }
+    /// Exchange the contents of two arrays, but not their allocators.
+    void swap_storage(dynamic_array &other)
+    {
+        using std::swap;
+        swap(m_capacity, other.m_capacity);
+        swap(m_size, other.m_size);
+        swap(m_storage, other.m_storage);
+    }
+    /// Exchange the allocators of two arrays when the allocator propagates.
+    void swap_allocator(dynamic_array &other, std::true_type)
+    {
+        using std::swap;
+        swap(m_allocator, other.m_allocator);
+    }
+    void swap_allocator(dynamic_array &, std::false_type)
+    {}
 private:
     length_t m_capacity;
     length_t m_size;
-    char *m_storage;
+    T *m_storage;
+    allocator_type m_allocator;
 };
 
+/// A dynamic_array whose storage is aligned to (at least) Align bytes.
+template <typename T, std::size_t Align, typename L = unsigned int>
+using aligned_dynamic_array = dynamic_array<T, L, aligned_allocator<T, Align>>;
@@ -0,0 +1,468 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "array_view.h"
+#include "dynamic_array.h"
+#include "simd_search.h"
+
+namespace flat_hash_detail {
+
+/// Control byte of a slot: empty, deleted (a tombstone), or the low 7 bits of the hash of the key
+/// of a full slot (0 to 127).
+using ctrl_t = std::int8_t;
+const ctrl_t ctrl_empty = -128;
+const ctrl_t ctrl_deleted = -2;
+
+/// Return the index of the lowest set bit of a non-zero mask.
+inline unsigned int lowest_bit(unsigned int mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return unsigned(__builtin_ctz(mask));
+#else
+    unsigned int bit = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/// A group of 16 control bytes, matched all at once with SSE2 on x86-64 (one bit per slot in the
+/// masks returned), or byte by byte elsewhere.
+struct group {
+    static const unsigned int width = 16;
+
+#ifdef CONTAINERS_SIMD_X86
+    explicit group(const ctrl_t *ctrl)
+        : m_ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)))
+    {}
+    /// Return the slots whose control byte is 'h2'.
+    unsigned int match(ctrl_t h2) const
+    {
+        return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(m_ctrl, _mm_set1_epi8(h2))));
+    }
+    unsigned int match_empty() const
+    {
+        return match(ctrl_empty);
+    }
+    /// Empty and deleted control bytes are the negative ones, so their sign bits are the mask.
+    unsigned int match_empty_or_deleted() const
+    {
+        return unsigned(_mm_movemask_epi8(m_ctrl));
+    }
+private:
+    __m128i m_ctrl;
+#else
+    explicit group(const ctrl_t *ctrl)
+    {
+        std::memcpy(m_ctrl, ctrl, width);
+    }
+    unsigned int match(ctrl_t h2) const
+    {
+        unsigned int mask = 0;
+        for (unsigned int i = 0; i < width; i++) {
+            mask |= unsigned(m_ctrl[i] == h2) << i;
+        }
+        return mask;
+    }
+    unsigned int match_empty() const
+    {
+        return match(ctrl_empty);
+    }
+    unsigned int match_empty_or_deleted() const
+    {
+        unsigned int mask = 0;
+        for (unsigned int i = 0; i < width; i++) {
+            mask |= unsigned(m_ctrl[i] < 0) << i;
+        }
+        return mask;
+    }
+private:
+    ctrl_t m_ctrl[width];
+#endif
+};
+
+} // namespace flat_hash_detail
+
+/**
+ * \brief A hash map storing its entries densely in a dynamic_array, indexed by an open-addressing
+ * table with SIMD-matched control bytes (Swiss-table style).
+ *
+ * The entries (std::pair<K, V>) are kept in insertion order in one array, so iterating over them
+ * runs at array speed and the map can be built from an existing array in one pass. A separate
+ * table maps hashes to entry indices: it has a control byte per slot, holding 7 bits of the hash
+ * of the slot's key, and the slots are probed 16 at a time, by comparing the control bytes of a
+ * whole group against the hash with one SSE2 instruction. Only the slots whose control byte
+ * matches are compared by key, so a lookup usually touches one group of control bytes, one slot
+ * and one entry. The table holds at most 7/8 of its capacity.
+ *
+ * Erasing an entry moves the last entry into its place (like dynamic_array::swap_remove), which
+ * changes the order of the entries and invalidates pointers to the last one. Keys must not be
+ * modified through iterators or pointers.
+ *
+ *     flat_hash_map<std::string, unsigned int> ids(std::move(pairs));   // bulk construction
+ *     if (const unsigned int *id = ids.find(name)) { ... }
+ *     ids[name] = 7;
+ *     for (auto &entry : ids) { ... }                                   // dense iteration
+ *
+ * The hash function H is post-mixed (by a multiplication and a shift), so that hashes with poor
+ * high or low bits, such as the identity std::hash of integers, spread over the table.
+ */
+template <typename K, typename V, typename H = std::hash<K>, typename E = std::equal_to<K>,
+          typename L = unsigned int>
+class flat_hash_map {
+public:
+    using length_t = L;
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using entries_type = dynamic_array<value_type, L>;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+    using hasher = H;
+    using key_equal = E;
+
+    /// Construct an empty map; no memory is allocated.
+    flat_hash_map()
+        : flat_hash_map(hasher())
+    {}
+    /// Construct an empty map using specific hash and equality functions.
+    explicit flat_hash_map(const hasher &hash, const key_equal &equal = key_equal())
+        : m_capacity(0), m_growth_left(0), m_hash(hash), m_equal(equal)
+    {}
+    /// Construct a map from an array of entries (copied, or moved with std::move), indexing them in
+    /// a single pass; of entries with equal keys, the first one is kept.
+    explicit flat_hash_map(entries_type entries, const hasher &hash = hasher(), const key_equal &equal = key_equal())
+        : m_entries(std::move(entries)), m_capacity(0), m_growth_left(0), m_hash(hash), m_equal(equal)
+    {
+        rehash(capacity_for(m_entries.size()));
+        if (m_growth_left + m_entries.size() != max_load(m_capacity)) {
+            remove_duplicates();
+        }
+    }
+    /// Make sure the map can hold 'count' entries without growing.
+    void reserve(length_t count)
+    {
+        m_entries.reserve(count);
+        if (count > max_load(m_capacity)) {
+            rehash(capacity_for(count));
+        }
+    }
+    /// Return the number of entries.
+    length_t size() const
+    {
+        return m_entries.size();
+    }
+    /// Return whether the map holds no entries.
+    bool empty() const
+    {
+        return m_entries.size() == 0;
+    }
+    /// Return a pointer to the value of a key, or nullptr if the key is not in the map.
+    V *find(const K &key)
+    {
+        length_t slot = find_slot(key, hash_of(key));
+        return slot == none ? nullptr : &m_entries.at_unchecked(m_slots.at_unchecked(slot)).second;
+    }
+    const V *find(const K &key) const
+    {
+        length_t slot = find_slot(key, hash_of(key));
+        return slot == none ? nullptr : &m_entries.at_unchecked(m_slots.at_unchecked(slot)).second;
+    }
+    /// Return whether a key is in the map.
+    bool contains(const K &key) const
+    {
+        return find_slot(key, hash_of(key)) != none;
+    }
+    /// Return the index of the entry of a key (see entries()), or size() if the key is not in the map.
+    length_t index_of(const K &key) const
+    {
+        length_t slot = find_slot(key, hash_of(key));
+        return slot == none ? size() : m_slots.at_unchecked(slot);
+    }
+    /// Return (a reference to) the value of a key; throws std::out_of_range if it is not in the map.
+    V &at(const K &key)
+    {
+        return *checked(find(key));
+    }
+    const V &at(const K &key) const
+    {
+        return *checked(find(key));
+    }
+    /// Return (a reference to) the value of a key, inserting a value-initialized one if the key is
+    /// not in the map.
+    V &operator[](K key)
+    {
+        return *try_emplace(std::move(key)).first;
+    }
+    /// Insert an entry for a key with a value constructed in place from 'args', unless the key is
+    /// already in the map (then nothing is constructed). Return a pointer to the value of the key
+    /// and whether it was inserted.
+    template <typename ...Args>
+    std::pair<V*, bool> try_emplace(K key, Args &&...args)
+    {
+        std::size_t hash = hash_of(key);
+        length_t slot = find_slot(key, hash);
+        if (slot != none) {
+            return std::make_pair(&m_entries.at_unchecked(m_slots.at_unchecked(slot)).second, false);
+        }
+        if (m_growth_left == 0) {
+            // Grow, unless most of the used slots are tombstones, which rehashing in place clears.
+            rehash(size() >= max_load(m_capacity) / 2 ? capacity_for(length_t(size() + 1)) : m_capacity);
+        }
+        slot = free_slot(hash);
+        m_entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+        if (m_ctrl.at_unchecked(slot) == flat_hash_detail::ctrl_empty) {
+            m_growth_left--;
+        }
+        set_slot(slot, hash, length_t(size() - 1));
+        return std::make_pair(&m_entries.last().second, true);
+    }
+    /// Insert an entry, unless its key is already in the map; return whether it was inserted.
+    bool insert(K key, V value)
+    {
+        return try_emplace(std::move(key), std::move(value)).second;
+    }
+    /// Insert an entry, or assign the value of its key if the key is already in the map; return
+    /// whether it was inserted.
+    bool insert_or_assign(K key, V value)
+    {
+        std::pair<V*, bool> result = try_emplace(std::move(key), std::move(value));
+        if (!result.second) {
+            *result.first = std::move(value);
+        }
+        return result.second;
+    }
+    /// Erase the entry of a key, moving the last entry into its place; return false (erasing
+    /// nothing) if the key is not in the map.
+    bool erase(const K &key)
+    {
+        length_t slot = find_slot(key, hash_of(key));
+        if (slot == none) {
+            return false;
+        }
+        length_t index = m_slots.at_unchecked(slot);
+        clear_slot(slot);
+        length_t last = size() - 1;
+        if (index != last) {
+            // Point the slot of the last entry at the entry's new place.
+            m_slots.at_unchecked(slot_of_index(last)) = index;
+        }
+        m_entries.swap_remove(int(index));
+        return true;
+    }
+    /// Erase all the entries; the capacity is kept.
+    void clear()
+    {
+        m_entries.clear();
+        if (m_capacity) {
+            std::memset(m_ctrl.data(), flat_hash_detail::ctrl_empty, m_capacity);
+        }
+        m_growth_left = max_load(m_capacity);
+    }
+    /// Return iterators over the entries, in storage order (insertion order, until an erasure).
+    iterator begin() { return m_entries.begin(); }
+    iterator end() { return m_entries.end(); }
+    const_iterator begin() const { return m_entries.begin(); }
+    const_iterator end() const { return m_entries.end(); }
+    /// Return a view of the entries, in storage order.
+    array_view<const value_type, L> entries() const
+    {
+        return m_entries.view();
+    }
+    /// Return the number of slots of the table (0, or a power of two of at least 16).
+    length_t capacity() const
+    {
+        return m_capacity;
+    }
+private:
+    static const length_t none = length_t(-1);
+    static const length_t group_width = flat_hash_detail::group::width;
+
+    /// Return the most slots a table of 'capacity' slots may fill (7/8 of them).
+    static length_t max_load(length_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+    /// Return the number of slots of a table for 'count' entries.
+    static length_t capacity_for(length_t count)
+    {
+        length_t capacity = group_width;
+        while (max_load(capacity) < count) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+    std::size_t hash_of(const K &key) const
+    {
+        // Fibonacci hashing: the multiplication carries every bit of the hash into the high bits,
+        // which select the group (h1); the low 7 bits of the result go to the control byte (h2).
+        std::uint64_t h = std::uint64_t(m_hash(key)) * 0x9E3779B97F4A7C15ull;
+        return std::size_t(h ^ (h >> 32));
+    }
+    static flat_hash_detail::ctrl_t h2(std::size_t hash)
+    {
+        return flat_hash_detail::ctrl_t(hash & 0x7F);
+    }
+    /// Return the first group of the probe sequence of a hash.
+    length_t first_group(std::size_t hash) const
+    {
+        return length_t(hash >> 7) & (m_capacity / group_width - 1);
+    }
+    /// Return the next group of a probe sequence, after 'step' more groups (triangular probing,
+    /// which visits every group since their number is a power of two).
+    length_t next_group(length_t g, length_t step) const
+    {
+        return (g + step) & (m_capacity / group_width - 1);
+    }
+    flat_hash_detail::group group_at(length_t g) const
+    {
+        return flat_hash_detail::group(m_ctrl.data() + g * group_width);
+    }
+    /// Return the slot holding a key, or none.
+    length_t find_slot(const K &key, std::size_t hash) const
+    {
+        if (m_capacity == 0) {
+            return none;
+        }
+        length_t g = first_group(hash);
+        for (length_t step = 1;; step++) {
+            flat_hash_detail::group grp = group_at(g);
+            for (unsigned int mask = grp.match(h2(hash)); mask; mask &= mask - 1) {
+                length_t slot = g * group_width + flat_hash_detail::lowest_bit(mask);
+                if (m_equal(m_entries.at_unchecked(m_slots.at_unchecked(slot)).first, key)) {
+                    return slot;
+                }
+            }
+            // A probe sequence ends at the first group with an empty slot.
+            if (grp.match_empty()) {
+                return none;
+            }
+            g = next_group(g, step);
+        }
+    }
+    /// Return the slot pointing at the entry at 'index'.
+    length_t slot_of_index(length_t index) const
+    {
+        std::size_t hash = hash_of(m_entries.at_unchecked(index).first);
+        length_t g = first_group(hash);
+        for (length_t step = 1;; step++) {
+            for (unsigned int mask = group_at(g).match(h2(hash)); mask; mask &= mask - 1) {
+                length_t slot = g * group_width + flat_hash_detail::lowest_bit(mask);
+                if (m_slots.at_unchecked(slot) == index) {
+                    return slot;
+                }
+            }
+            g = next_group(g, step);
+        }
+    }
+    /// Return the first empty or deleted slot of the probe sequence of a hash (the table must not
+    /// be full).
+    length_t free_slot(std::size_t hash) const
+    {
+        length_t g = first_group(hash);
+        for (length_t step = 1;; step++) {
+            unsigned int mask = group_at(g).match_empty_or_deleted();
+            if (mask) {
+                return g * group_width + flat_hash_detail::lowest_bit(mask);
+            }
+            g = next_group(g, step);
+        }
+    }
+    void set_slot(length_t slot, std::size_t hash, length_t index)
+    {
+        m_ctrl.at_unchecked(slot) = h2(hash);
+        m_slots.at_unchecked(slot) = index;
+    }
+    /// Free a full slot. If its group has an empty slot, no probe sequence continues past the
+    /// group, so the slot can become empty too; otherwise it becomes a tombstone, which keeps the
+    /// probe sequences through it going.
+    void clear_slot(length_t slot)
+    {
+        if (group_at(slot / group_width).match_empty()) {
+            m_ctrl.at_unchecked(slot) = flat_hash_detail::ctrl_empty;
+            m_growth_left++;
+        }
+        else {
+            m_ctrl.at_unchecked(slot) = flat_hash_detail::ctrl_deleted;
+        }
+    }
+    /// Rebuild the table with 'capacity' slots, dropping the tombstones. Entries whose key is
+    /// already indexed are left out of the table (see remove_duplicates()).
+    void rehash(length_t capacity)
+    {
+        dynamic_array<flat_hash_detail::ctrl_t, L> ctrl(capacity);
+        dynamic_array<length_t, L> slots(capacity);
+        ctrl.resize_uninitialized(capacity);
+        slots.resize_uninitialized(capacity);
+        std::memset(ctrl.data(), flat_hash_detail::ctrl_empty, capacity);
+        m_ctrl = std::move(ctrl);
+        m_slots = std::move(slots);
+        m_capacity = capacity;
+        m_growth_left = max_load(capacity);
+        for (length_t i = 0; i < size(); i++) {
+            const K &key = m_entries.at_unchecked(i).first;
+            std::size_t hash = hash_of(key);
+            if (find_slot(key, hash) == none) {
+                set_slot(free_slot(hash), hash, i);
+                m_growth_left--;
+            }
+        }
+    }
+    /// Drop the entries rehash() left out of the table, which repeat an earlier key, and index the
+    /// others again.
+    void remove_duplicates()
+    {
+        // Find the indexed entries before moving any, since the lookups compare their keys.
+        dynamic_array<bool, L> indexed(size());
+        for (length_t i = 0; i < size(); i++) {
+            const K &key = m_entries.at_unchecked(i).first;
+            indexed.push_back(m_slots.at_unchecked(find_slot(key, hash_of(key))) == i);
+        }
+        entries_type unique(max_load(m_capacity) - m_growth_left);
+        for (length_t i = 0; i < size(); i++) {
+            if (indexed.at_unchecked(i)) {
+                unique.push_back(std::move(m_entries.at_unchecked(i)));
+            }
+        }
+        m_entries = std::move(unique);
+        rehash(m_capacity);
+    }
+    static V *checked(V *value)
+    {
+        if (!value) {
+            throw std::out_of_range("key not in flat_hash_map");
+        }
+        return value;
+    }
+    static const V *checked(const V *value)
+    {
+        if (!value) {
+            throw std::out_of_range("key not in flat_hash_map");
+        }
+        return value;
+    }
+
+    entries_type m_entries;
+    /// The control byte of each slot of the table.
+    dynamic_array<flat_hash_detail::ctrl_t, L> m_ctrl;
+    /// The index of the entry of each full slot.
+    dynamic_array<length_t, L> m_slots;
+    length_t m_capacity;
+    /// The number of empty slots that may still be filled before the table must grow.
+    length_t m_growth_left;
+    hasher m_hash;
+    key_equal m_equal;
+};
+
+template <typename K, typename V, typename H, typename E, typename L>
+const L flat_hash_map<K, V, H, E, L>::none;
+template <typename K, typename V, typename H, typename E, typename L>
+const L flat_hash_map<K, V, H, E, L>::group_width;
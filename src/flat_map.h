@@ -0,0 +1,210 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "array_algorithms.h"
+#include "array_view.h"
+#include "dynamic_array.h"
+
+/**
+ * \brief A map storing its entries in a dynamic_array sorted by key, looked up by binary search.
+ *
+ * Lookups take O(log n) comparisons with the branchless lower bound of array_algorithms, over
+ * one contiguous array, with no pointer chasing; iteration is in key order at array speed.
+ * Inserting or erasing an entry shifts the entries after it, so it is O(n): the map suits data
+ * that is built once (e.g. from an existing array, which is sorted in one go) and then mostly
+ * read. Keys must not be modified through iterators or pointers.
+ *
+ *     flat_map<unsigned int, std::string> names(std::move(pairs));   // bulk construction
+ *     if (const std::string *name = names.find(id)) { ... }
+ *     for (auto &entry : names) { ... }                             // in key order
+ *
+ * Keys are compared with C (std::less<K> by default); keys are equal if neither is ordered
+ * before the other.
+ */
+template <typename K, typename V, typename C = std::less<K>, typename L = unsigned int>
+class flat_map {
+public:
+    using length_t = L;
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using entries_type = dynamic_array<value_type, L>;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+    using key_compare = C;
+
+    /// Construct an empty map; no memory is allocated.
+    flat_map()
+        : flat_map(key_compare())
+    {}
+    /// Construct an empty map using a specific comparison function.
+    explicit flat_map(const key_compare &less)
+        : m_less(less)
+    {}
+    /// Construct a map from an array of entries (copied, or moved with std::move), sorting them
+    /// once; of entries with equal keys, the first one is kept.
+    explicit flat_map(entries_type entries, const key_compare &less = key_compare())
+        : m_entries(std::move(entries)), m_less(less)
+    {
+        entry_less by_key{m_less};
+        std::stable_sort(m_entries.begin(), m_entries.end(), by_key);
+        iterator last = std::unique(m_entries.begin(), m_entries.end(), [&by_key](const value_type &a, const value_type &b) {
+            return !by_key(a, b);
+        });
+        m_entries.erase(length_t(last - m_entries.begin()), m_entries.size());
+    }
+    /// Make sure the map can hold 'count' entries without growing.
+    void reserve(length_t count)
+    {
+        m_entries.reserve(count);
+    }
+    /// Return the number of entries.
+    length_t size() const
+    {
+        return m_entries.size();
+    }
+    /// Return whether the map holds no entries.
+    bool empty() const
+    {
+        return m_entries.size() == 0;
+    }
+    /// Return the index of the first entry whose key is not ordered before 'key', or size() if
+    /// there is none.
+    length_t lower_bound(const K &key) const
+    {
+        const key_compare &less = m_less;
+        return array_algorithms::lower_bound(m_entries.data(), m_entries.size(), key,
+                                             [&less](const value_type &entry, const K &k) { return less(entry.first, k); });
+    }
+    /// Return the index of the first entry whose key is ordered after 'key', or size() if there
+    /// is none.
+    length_t upper_bound(const K &key) const
+    {
+        const key_compare &less = m_less;
+        return array_algorithms::lower_bound(m_entries.data(), m_entries.size(), key,
+                                             [&less](const value_type &entry, const K &k) { return !less(k, entry.first); });
+    }
+    /// Return the index of the entry of a key (see entries()), or size() if the key is not in the map.
+    length_t index_of(const K &key) const
+    {
+        length_t index = lower_bound(key);
+        return index < size() && !m_less(key, m_entries.at_unchecked(index).first) ? index : size();
+    }
+    /// Return a pointer to the value of a key, or nullptr if the key is not in the map.
+    V *find(const K &key)
+    {
+        length_t index = index_of(key);
+        return index < size() ? &m_entries.at_unchecked(index).second : nullptr;
+    }
+    const V *find(const K &key) const
+    {
+        length_t index = index_of(key);
+        return index < size() ? &m_entries.at_unchecked(index).second : nullptr;
+    }
+    /// Return whether a key is in the map.
+    bool contains(const K &key) const
+    {
+        return index_of(key) < size();
+    }
+    /// Return (a reference to) the value of a key; throws std::out_of_range if it is not in the map.
+    V &at(const K &key)
+    {
+        return *checked(find(key));
+    }
+    const V &at(const K &key) const
+    {
+        return *checked(find(key));
+    }
+    /// Return (a reference to) the value of a key, inserting a value-initialized one if the key is
+    /// not in the map.
+    V &operator[](K key)
+    {
+        return *try_emplace(std::move(key)).first;
+    }
+    /// Insert an entry for a key with a value constructed from 'args', unless the key is already
+    /// in the map (then nothing is constructed), shifting forward the entries ordered after it.
+    /// Return a pointer to the value of the key and whether it was inserted.
+    template <typename ...Args>
+    std::pair<V*, bool> try_emplace(K key, Args &&...args)
+    {
+        length_t index = lower_bound(key);
+        if (index < size() && !m_less(key, m_entries.at_unchecked(index).first)) {
+            return std::make_pair(&m_entries.at_unchecked(index).second, false);
+        }
+        m_entries.shift_insert(index, value_type(std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                                                 std::forward_as_tuple(std::forward<Args>(args)...)));
+        return std::make_pair(&m_entries.at_unchecked(index).second, true);
+    }
+    /// Insert an entry, unless its key is already in the map; return whether it was inserted.
+    bool insert(K key, V value)
+    {
+        return try_emplace(std::move(key), std::move(value)).second;
+    }
+    /// Insert an entry, or assign the value of its key if the key is already in the map; return
+    /// whether it was inserted.
+    bool insert_or_assign(K key, V value)
+    {
+        std::pair<V*, bool> result = try_emplace(std::move(key), std::move(value));
+        if (!result.second) {
+            *result.first = std::move(value);
+        }
+        return result.second;
+    }
+    /// Erase the entry of a key, shifting back the entries after it; return false (erasing
+    /// nothing) if the key is not in the map.
+    bool erase(const K &key)
+    {
+        length_t index = index_of(key);
+        if (index == size()) {
+            return false;
+        }
+        m_entries.shift_remove(int(index));
+        return true;
+    }
+    /// Erase all the entries; the capacity is kept.
+    void clear()
+    {
+        m_entries.clear();
+    }
+    /// Return iterators over the entries, in key order.
+    iterator begin() { return m_entries.begin(); }
+    iterator end() { return m_entries.end(); }
+    const_iterator begin() const { return m_entries.begin(); }
+    const_iterator end() const { return m_entries.end(); }
+    /// Return a view of the entries, in key order.
+    array_view<const value_type, L> entries() const
+    {
+        return m_entries.view();
+    }
+private:
+    /// Orders entries by key.
+    struct entry_less {
+        const key_compare &less;
+
+        bool operator()(const value_type &a, const value_type &b) const
+        {
+            return less(a.first, b.first);
+        }
+    };
+
+    static V *checked(V *value)
+    {
+        if (!value) {
+            throw std::out_of_range("key not in flat_map");
+        }
+        return value;
+    }
+    static const V *checked(const V *value)
+    {
+        if (!value) {
+            throw std::out_of_range("key not in flat_map");
+        }
+        return value;
+    }
+
+    entries_type m_entries;
+    key_compare m_less;
+};
@@ -0,0 +1,220 @@
+#pragma once
+#include <atomic>
+#include <utility>
+#include "array_view.h"
+#include "dynamic_array.h"
+
+/**
+ * \brief An immutable, reference-counted snapshot of a dynamic_array, which is copied in O(1).
+ *
+ * Copies of a frozen_array share the same items, through an atomic owner count, so handing a
+ * snapshot (e.g. of a configuration) to many readers costs one reference count increment per
+ * reader instead of a deep copy. The items are read through the const interface of the array
+ * (operator[], data(), iterators, views and searches).
+ *
+ * A snapshot is made by dynamic_array::freeze(), which moves the items into the snapshot when
+ * called on an rvalue, or copies them once otherwise:
+ *
+ *     dynamic_array<setting> settings = load();
+ *     frozen_array<setting> snapshot = std::move(settings).freeze();  // no copies
+ *     frozen_array<setting> for_reader = snapshot;                    // O(1)
+ *
+ * A snapshot is modified by copy-on-write: edit() returns the array for modification, copying
+ * the items first only if they are shared with other snapshots, and thaw() turns a snapshot back
+ * into a dynamic_array, moving the items out when the snapshot is their only owner.
+ *
+ * Thread safety follows std::shared_ptr: any number of threads may read and copy a snapshot at
+ * once, and different snapshots of the same items may be used (and edited) by different threads,
+ * but a single frozen_array object must not be assigned or edited while other threads use it.
+ * Dropping a snapshot decrements the owner count with release semantics, and edit() and thaw()
+ * read it with acquire semantics, so a snapshot that finds itself the only owner has seen every
+ * read made through the copies dropped meanwhile before it writes the items; two snapshots
+ * racing to edit shared items may both copy them.
+ */
+
+template <typename T, typename L = unsigned int, typename A = aligned_allocator<T>,
+          typename G = doubling_growth, typename S = no_stats, typename B = bounds_checked>
+class frozen_array {
+public:
+    using array_type = dynamic_array<T, L, A, G, S, B>;
+    using length_t = L;
+    using value_type = T;
+    using const_iterator = const T*;
+
+    /// Construct an empty snapshot; no memory is allocated.
+    frozen_array()
+        : m_shared(nullptr)
+    {}
+    /// Take over the items of an array (which is left empty) without copying them.
+    explicit frozen_array(array_type &&array)
+        : m_shared(new shared_items(std::move(array)))
+    {}
+    /// Make a snapshot of copies of the items of an array.
+    explicit frozen_array(const array_type &array)
+        : m_shared(new shared_items(array))
+    {}
+    /// Copy-constructor; shares the items of the other snapshot.
+    frozen_array(const frozen_array &other)
+        : m_shared(other.m_shared)
+    {
+        if (m_shared) {
+            m_shared->owners.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    /// Move-constructor; takes over the items of the other snapshot, which is left empty.
+    frozen_array(frozen_array &&other) noexcept
+        : m_shared(other.m_shared)
+    {
+        other.m_shared = nullptr;
+    }
+    /// Copy-assignment operator; shares the items of the other snapshot.
+    frozen_array &operator=(const frozen_array &other)
+    {
+        frozen_array copy(other);
+        std::swap(m_shared, copy.m_shared);
+        return *this;
+    }
+    /// Move-assignment operator.
+    frozen_array &operator=(frozen_array &&other) noexcept
+    {
+        std::swap(m_shared, other.m_shared);
+        return *this;
+    }
+    /// Destructor; the last snapshot of the items destroys them.
+    ~frozen_array()
+    {
+        release();
+    }
+    /// Return the size of the array (number of items contained).
+    length_t size() const
+    {
+        return m_shared ? m_shared->array.size() : 0;
+    }
+    /// Return whether the snapshot holds no items.
+    bool empty() const
+    {
+        return size() == 0;
+    }
+    /// Return (a reference to) the element at position 'index'; throws std::out_of_range if index >= size.
+    const T &operator[](length_t index) const
+    {
+        return view()[index];
+    }
+    /// Return the first item.
+    const T &first() const { return (*this)[0]; }
+    /// Return the last item.
+    const T &last() const { return (*this)[size() - 1]; }
+    /// Return raw (read-only) access to data
+    const T *data() const
+    {
+        return m_shared ? m_shared->array.data() : nullptr;
+    }
+    /// Return iterators (raw pointers) to the beginning and the end of the items; they stay valid
+    /// as long as a snapshot of the items exists.
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    /// Return a view of all the items.
+    array_view<const T, L> view() const
+    {
+        return array_view<const T, L>(data(), size());
+    }
+    /// Convert to a view of all the items, e.g. to pass the snapshot to a function taking a view.
+    operator array_view<const T, L>() const
+    {
+        return view();
+    }
+    /// Return whether two snapshots share the same items.
+    bool shares(const frozen_array &other) const
+    {
+        return m_shared == other.m_shared;
+    }
+    /// Return the array for modification, after copying the items if other snapshots share them.
+    /// The reference is only valid until the snapshot is copied, assigned or destroyed; copying
+    /// the snapshot shares the modified items again.
+    array_type &edit()
+    {
+        if (!m_shared) {
+            m_shared = new shared_items(array_type());
+        }
+        else if (!unique()) {
+            shared_items *copy = new shared_items(static_cast<const array_type&>(m_shared->array));
+            release();
+            m_shared = copy;
+        }
+        return m_shared->array;
+    }
+    /// Return a copy of the items as a dynamic_array.
+    array_type thaw() const &
+    {
+        return m_shared ? array_type(m_shared->array) : array_type();
+    }
+    /// Turn the snapshot into a dynamic_array, moving the items out if the snapshot is their only
+    /// owner, and copying them otherwise; the snapshot is left empty.
+    array_type thaw() &&
+    {
+        frozen_array snapshot(std::move(*this));
+        if (!snapshot.m_shared) {
+            return array_type();
+        }
+        return snapshot.unique() ? array_type(std::move(snapshot.m_shared->array)) : array_type(snapshot.m_shared->array);
+    }
+    /// Perform a linear search for an item equal to 'value'; see dynamic_array::linearSearch().
+    length_t linearSearch(const T &value) const
+    {
+        return view().linearSearch(value);
+    }
+    /// Perform a binary search on items sorted by operator<; see dynamic_array::binarySearch().
+    length_t binarySearch(const T &value) const
+    {
+        return view().binarySearch(value);
+    }
+    /// Return the number of items equal to 'value'.
+    length_t count(const T &value) const
+    {
+        return view().count(value);
+    }
+private:
+    /// The items and the number of snapshots sharing them.
+    struct shared_items {
+        template <typename Array>
+        explicit shared_items(Array &&items)
+            : array(std::forward<Array>(items)), owners(1)
+        {}
+
+        array_type array;
+        std::atomic<long> owners;
+    };
+
+    /// Return whether this snapshot is the only owner of its (non-null) items; the acquire load
+    /// pairs with the release decrements of the snapshots dropped, so their reads happen before
+    /// any write through this one.
+    bool unique() const
+    {
+        return m_shared->owners.load(std::memory_order_acquire) == 1;
+    }
+    /// Drop this snapshot's share of the items, destroying them if it was the last one.
+    void release()
+    {
+        if (m_shared && m_shared->owners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete m_shared;
+        }
+        m_shared = nullptr;
+    }
+
+    /// The shared items; null for an empty snapshot that never held any.
+    shared_items *m_shared;
+};
+
+template <typename T, typename L, typename A, typename G, typename S, typename B>
+frozen_array<T, L, A, G, S, B> dynamic_array<T, L, A, G, S, B>::freeze() const &
+{
+    return frozen_array<T, L, A, G, S, B>(*this);
+}
+
+template <typename T, typename L, typename A, typename G, typename S, typename B>
+frozen_array<T, L, A, G, S, B> dynamic_array<T, L, A, G, S, B>::freeze() &&
+{
+    return frozen_array<T, L, A, G, S, B>(std::move(*this));
+}
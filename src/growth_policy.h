@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+/**
+ * \brief Growth policies deciding the new capacity of an array that has to grow.
+ *
+ * A growth policy is a class with a static member function template
+ *
+ *     template <typename T, typename L>
+ *     static L next_capacity(L capacity, L required);
+ *
+ * returning the capacity to grow an array of T into, when its current 'capacity' cannot hold
+ * 'required' items. The returned value must be at least 'required'.
+ *
+ * A policy may also shrink arrays as items are deleted, with a second function template
+ *
+ *     template <typename T, typename L>
+ *     static L shrink_capacity(L capacity, L size);
+ *
+ * returning the capacity to shrink an array of T holding 'size' items into (at least 'size'), or
+ * 'capacity' to leave it as it is; zero releases the buffer. Arrays call it after every deletion,
+ * so the policy should leave enough room, between the sizes triggering a shrink and a growth, for
+ * alternating insertions and deletions not to reallocate every time.
+ */
+
+/// Grow by doubling the capacity, starting from a single item.
+struct doubling_growth {
+    template <typename T, typename L>
+    static L next_capacity(L capacity, L required)
+    {
+        const L max = std::numeric_limits<L>::max();
+        L next = !capacity ? 1 : capacity > max / 2 ? max : 2 * capacity;
+        return next < required ? required : next;
+    }
+};
+
+/**
+ * \brief Grow by a factor of Num/Den (1.5 by default), within bounds given in bytes.
+ *
+ *  - A factor below the golden ratio lets a sequence of reallocations eventually reuse the memory
+ *    released by the previous ones, and wastes at most a third of the capacity instead of half.
+ *  - The first allocation holds at least MinBytes bytes (and at least one item), so arrays of
+ *    small items skip the 1, 2, 4, ... sequence of tiny reallocations.
+ *  - If MaxIncrementBytes is not zero, the capacity never grows by more than that many bytes at
+ *    once, so very large arrays grow linearly instead of overshooting by gigabytes.
+ */
+template <unsigned int Num = 3, unsigned int Den = 2,
+          std::size_t MinBytes = 64, std::size_t MaxIncrementBytes = 0>
+struct geometric_growth {
+    static_assert(Num > Den && Den > 0, "the growth factor must be greater than one");
+
+    template <typename T, typename L>
+    static L next_capacity(L capacity, L required)
+    {
+        const std::size_t max = std::numeric_limits<L>::max();
+        std::size_t next;
+        if (!capacity) {
+            next = MinBytes / sizeof(T);
+        }
+        else {
+            std::size_t increment = capacity / Den * (Num - Den) + capacity % Den * (Num - Den) / Den;
+            if (MaxIncrementBytes && increment > MaxIncrementBytes / sizeof(T)) {
+                increment = MaxIncrementBytes / sizeof(T);
+            }
+            if (!increment) {
+                increment = 1;
+            }
+            next = increment > max - capacity ? max : capacity + increment;
+        }
+        if (next > max) {
+            next = max;
+        }
+        return next < required ? required : static_cast<L>(next);
+    }
+};
+
+/**
+ * \brief Grow as the policy G does, and halve the capacity while the items fill less than
+ * 1/Sparse of it (a quarter by default).
+ *
+ * After shrinking, the items fill between 1/Sparse and 2/Sparse of the capacity, so with the
+ * default doubling growth an array must double in size before it grows again, or lose half of
+ * its items before it shrinks again: pushing and popping at a boundary does not reallocate each
+ * time. The capacity never shrinks below MinBytes bytes, and a capacity of fewer than Sparse
+ * items is never halved, so that an emptied array keeps a tiny buffer instead of thrashing
+ * between zero and one item; use shrink_to_fit() to release it.
+ */
+template <typename G = doubling_growth, unsigned int Sparse = 4, std::size_t MinBytes = 0>
+struct shrinking_growth : G {
+    static_assert(Sparse > 2, "the items must fill less than half of the capacity before shrinking");
+
+    template <typename T, typename L>
+    static L shrink_capacity(L capacity, L size)
+    {
+        const L min = L(MinBytes / sizeof(T));
+        L next = capacity;
+        while (next > min && size < next / Sparse) {
+            next /= 2;
+        }
+        return next < min ? min : next;
+    }
+};
+
+/// Trait detecting growth policies that shrink arrays (that have shrink_capacity()).
+template <typename G, typename = void>
+struct growth_policy_shrinks : std::false_type {};
+
+template <typename G>
+struct growth_policy_shrinks<G, decltype((void)G::template shrink_capacity<char>(0u, 0u))> : std::true_type {};
@@ -0,0 +1,425 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "aligned_allocator.h"
+#include "array_algorithms.h"
+#include "array_view.h"
+#include "growth_policy.h"
+
+/**
+ * \brief A dynamic array that spreads the relocation of its items over the operations following
+ * a growth, so that no single push_back() copies the whole array.
+ *
+ * When the array is full, push_back() allocates the buffer of the new capacity (as the growth
+ * policy G dictates) and puts the new item there, but leaves the other items in the old buffer.
+ * Each following operation that modifies the array (push_back(), emplace_back(), pop_back(),
+ * swap_remove()) then relocates a bounded number of items from the old buffer into the new one,
+ * like incremental rehashing in a hash table; the old buffer is released once it is empty. This
+ * bounds the work of an insertion to one allocation plus a few relocations, instead of the
+ * millisecond stall of relocating a large array at once.
+ *
+ * While items are migrating (see migrating()), the items below an index are still in the old
+ * buffer, so operator[] picks the buffer with one more comparison than dynamic_array, and the
+ * items are not contiguous: data() and view() finish the migration first, and for_each()
+ * visits the items in both buffers without doing so. Relocating at least Step items per
+ * operation, and more if the growth policy leaves fewer operations before the next growth than
+ * there are items to migrate, makes sure a migration ends before the array fills up again.
+ *
+ * Both buffers are held during a migration, so the peak memory use is the same as when
+ * dynamic_array grows; reserve() relocates at once, as it is meant for a non-critical moment.
+ * The operation ending a migration frees the old buffer, which for a buffer of many megabytes
+ * (returned to the system page by page) is then the slowest step, though still much faster than
+ * relocating its items. For trivially relocatable items dynamic_array may grow cheaply already,
+ * through realloc() (see allocator_has_reallocate).
+ * The buffers are obtained from an allocator of type A, rebound to T; it is copied along with
+ * the array and moved along with its buffers.
+ *
+ *     incremental_dynamic_array<order> orders;
+ *     orders.push_back(o);                    // never relocates more than a few items
+ *     for (unsigned int i = 0; i < orders.size(); i++) { ... orders[i] ... }
+ */
+
+template <typename T, typename L = unsigned int, unsigned int Step = 16, typename A = aligned_allocator<T>,
+          typename G = doubling_growth>
+class incremental_dynamic_array {
+    using alloc_traits = typename std::allocator_traits<A>::template rebind_traits<T>;
+    static_assert(Step > 0, "at least one item must be relocated per operation");
+public:
+    using length_t = L;
+    using allocator_type = typename alloc_traits::allocator_type;
+    using value_type = T;
+    using growth_policy = G;
+
+    /// Default constructor; no memory is allocated until the first item is added.
+    incremental_dynamic_array()
+        : incremental_dynamic_array(allocator_type())
+    {}
+    /// Construct an empty array using a specific allocator.
+    explicit incremental_dynamic_array(const allocator_type &alloc)
+        : m_storage(nullptr), m_capacity(0), m_size(0), m_old(nullptr), m_old_capacity(0), m_pending(0),
+          m_step(Step), m_allocator(alloc)
+    {}
+    /// Copy-constructor; copies the items into a single buffer of the size of the array.
+    incremental_dynamic_array(const incremental_dynamic_array &other)
+        : incremental_dynamic_array(alloc_traits::select_on_container_copy_construction(other.m_allocator))
+    {
+        if (!other.m_size) {
+            return;
+        }
+        m_storage = alloc_traits::allocate(m_allocator, other.m_size);
+        m_capacity = other.m_size;
+        array_algorithms::uninitialized_copy(m_storage, other.m_old, other.m_pending);
+        try {
+            array_algorithms::uninitialized_copy(m_storage + other.m_pending, other.m_storage + other.m_pending,
+                                                 length_t(other.m_size - other.m_pending));
+        }
+        catch (...) {
+            for (length_t i = 0; i < other.m_pending; i++) {
+                m_storage[i].~T();
+            }
+            throw;
+        }
+        m_size = other.m_size;
+    }
+    /// Move-constructor; takes over the buffers (and the allocator) of another array.
+    incremental_dynamic_array(incremental_dynamic_array &&other) noexcept
+        : incremental_dynamic_array(std::move(other.m_allocator))
+    {
+        swap_storage(other);
+    }
+    /// Copy-assignment operator.
+    incremental_dynamic_array &operator=(const incremental_dynamic_array &other)
+    {
+        if (this != &other) {
+            incremental_dynamic_array temp(other);
+            swap(*this, temp);
+        }
+        return *this;
+    }
+    /// Move-assignment operator; exchanges the buffers (and the allocators) of the arrays.
+    incremental_dynamic_array &operator=(incremental_dynamic_array &&other) noexcept
+    {
+        swap(*this, other);
+        return *this;
+    }
+    /// Destructor.
+    ~incremental_dynamic_array()
+    {
+        destroy_items();
+        release_old();
+        if (m_storage) {
+            alloc_traits::deallocate(m_allocator, m_storage, m_capacity);
+        }
+    }
+    /// Swap two arrays, along with their allocators.
+    friend void swap(incremental_dynamic_array &first, incremental_dynamic_array &second) noexcept
+    {
+        using std::swap;
+        first.swap_storage(second);
+        swap(first.m_allocator, second.m_allocator);
+    }
+    /// Add a copy of an element to the end; the element may be an item of the array itself.
+    void push_back(const T &element)
+    {
+        emplace_back(element);
+    }
+    /// Add an element to the end by moving it into place.
+    void push_back(T &&element)
+    {
+        emplace_back(std::move(element));
+    }
+    /// Construct an element in place at the end, then relocate a few migrating items; if the array
+    /// is full, allocate a larger buffer and start migrating into it. Return a reference to the
+    /// element.
+    template <typename ...Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (m_size == m_capacity) {
+            return emplace_back_grow(std::forward<Args>(args)...);
+        }
+        // Construct first: the arguments may refer to items that migrate.
+        new (m_storage + m_size) T(std::forward<Args>(args)...);
+        m_size++;
+        try {
+            migrate();
+        }
+        catch (...) {
+            m_storage[--m_size].~T();
+            throw;
+        }
+        return m_storage[m_size - 1];
+    }
+    /// Delete the last element, then relocate a few migrating items.
+    void pop_back()
+    {
+        destroy_last();
+        migrate();
+    }
+    /// Delete an element by moving the last one on top of it, then relocate a few migrating items.
+    void swap_remove(length_t index)
+    {
+        check_index(index);
+        array_algorithms::swap_remove(&item(index), &item(m_size - 1));
+        forget_last();
+        migrate();
+    }
+    /// Delete all the items; the capacity of the new buffer is kept, while the old one is released.
+    void clear()
+    {
+        destroy_items();
+        release_old();
+        m_size = 0;
+    }
+    /// Make sure the array can hold at least 'capacity' items without growing; this finishes any
+    /// migration and relocates the items at once.
+    void reserve(length_t capacity)
+    {
+        finish_migration();
+        if (capacity > m_capacity) {
+            T *storage = alloc_traits::allocate(m_allocator, capacity);
+            try {
+                array_algorithms::relocate(storage, m_storage, m_size);
+            }
+            catch (...) {
+                alloc_traits::deallocate(m_allocator, storage, capacity);
+                throw;
+            }
+            if (m_storage) {
+                alloc_traits::deallocate(m_allocator, m_storage, m_capacity);
+            }
+            m_storage = storage;
+            m_capacity = capacity;
+        }
+    }
+    /// Relocate all the migrating items now, e.g. at a moment when latency does not matter.
+    void finish_migration()
+    {
+        if (m_pending) {
+            array_algorithms::relocate(m_storage, m_old, m_pending);
+            m_pending = 0;
+            release_old();
+        }
+    }
+    /// Return whether items are still migrating from the old buffer.
+    bool migrating() const
+    {
+        return m_pending != 0;
+    }
+    /// Return the size of the array (number of items contained).
+    length_t size() const
+    {
+        return m_size;
+    }
+    /// Return the capacity of the array (of its new buffer while migrating).
+    length_t capacity() const
+    {
+        return m_capacity;
+    }
+    /// Return whether the array holds no items.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+    /// Return (a reference to) the element at position 'index', in whichever buffer it is; throws
+    /// std::out_of_range if index >= size.
+    T &operator[](length_t index)
+    {
+        check_index(index);
+        return item(index);
+    }
+    const T &operator[](length_t index) const
+    {
+        check_index(index);
+        return item(index);
+    }
+    /// Return (a reference to) the element at position 'index' without checking the index;
+    /// checked only in DEBUG builds.
+    T &at_unchecked(length_t index)
+    {
+#ifdef DEBUG
+        check_index(index);
+#endif
+        return item(index);
+    }
+    const T &at_unchecked(length_t index) const
+    {
+#ifdef DEBUG
+        check_index(index);
+#endif
+        return item(index);
+    }
+    /// Return the first item.
+    T &first() { return (*this)[0]; }
+    const T &first() const { return (*this)[0]; }
+    /// Return the last item.
+    T &last() { return (*this)[m_size - 1]; }
+    const T &last() const { return (*this)[m_size - 1]; }
+    /// Return raw access to the items, after finishing any migration.
+    T *data()
+    {
+        finish_migration();
+        return m_storage;
+    }
+    /// Return a view of all the items, after finishing any migration.
+    array_view<T, L> view()
+    {
+        return array_view<T, L>(data(), m_size);
+    }
+    /// Call f(item) for each item in order, in whichever buffer it is.
+    template <typename F>
+    void for_each(F f)
+    {
+        for (length_t i = 0; i < m_pending; i++) {
+            f(m_old[i]);
+        }
+        for (length_t i = m_pending; i < m_size; i++) {
+            f(m_storage[i]);
+        }
+    }
+    template <typename F>
+    void for_each(F f) const
+    {
+        for (length_t i = 0; i < m_pending; i++) {
+            f(static_cast<const T&>(m_old[i]));
+        }
+        for (length_t i = m_pending; i < m_size; i++) {
+            f(static_cast<const T&>(m_storage[i]));
+        }
+    }
+private:
+    /// Return the item at 'index': the items below m_pending are still in the old buffer.
+    T &item(length_t index)
+    {
+        return index < m_pending ? m_old[index] : m_storage[index];
+    }
+    const T &item(length_t index) const
+    {
+        return index < m_pending ? m_old[index] : m_storage[index];
+    }
+    void check_index(length_t index) const
+    {
+        if (index >= m_size) {
+            throw std::out_of_range("index out of range");
+        }
+    }
+    /// emplace_back() into a full array: construct the element in a new buffer, while the other
+    /// items (which the arguments may refer to) stay in place, and start migrating them.
+    template <typename ...Args>
+    T &emplace_back_grow(Args &&...args)
+    {
+        if (m_pending) {
+            // Only left over if a relocation threw: finish the migration, which may move the
+            // items the arguments refer to, after constructing the element.
+            T element(std::forward<Args>(args)...);
+            finish_migration();
+            return emplace_back_grow(std::move(element));
+        }
+        length_t capacity = growth_policy::template next_capacity<T>(m_capacity, length_t(m_size + 1));
+        T *storage = alloc_traits::allocate(m_allocator, capacity);
+        try {
+            new (storage + m_size) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            alloc_traits::deallocate(m_allocator, storage, capacity);
+            throw;
+        }
+        m_old = m_storage;
+        m_old_capacity = m_capacity;
+        m_pending = m_size;
+        m_storage = storage;
+        m_capacity = capacity;
+        m_size++;
+        // Relocate enough items per operation to finish before the new buffer is full: this
+        // operation and one per item of room left.
+        length_t operations = length_t(m_capacity - m_size + 1);
+        length_t needed = length_t((m_pending + operations - 1) / operations);
+        m_step = needed > Step ? needed : length_t(Step);
+        try {
+            migrate();
+        }
+        catch (...) {
+            m_storage[--m_size].~T();
+            throw;
+        }
+        return m_storage[m_size - 1];
+    }
+    /// Relocate up to m_step items from the end of the old buffer into the new one.
+    void migrate()
+    {
+        if (m_pending) {
+            length_t count = m_pending < m_step ? m_pending : m_step;
+            length_t first = length_t(m_pending - count);
+            array_algorithms::relocate(m_storage + first, m_old + first, count);
+            m_pending = first;
+            if (!m_pending) {
+                release_old();
+            }
+        }
+    }
+    /// Destroy the last item and forget it.
+    void destroy_last()
+    {
+        item(m_size - 1).~T();
+        forget_last();
+    }
+    /// Shrink the size by one; the last item has already been destroyed or relocated.
+    void forget_last()
+    {
+        m_size--;
+        if (m_pending > m_size) {
+            // No items had been added or migrated, so the last item was in the old buffer.
+            m_pending = m_size;
+            if (!m_pending) {
+                release_old();
+            }
+        }
+    }
+    /// Destroy all items, in both buffers; the size is left unchanged.
+    void destroy_items()
+    {
+        for (length_t i = 0; i < m_pending; i++) {
+            m_old[i].~T();
+        }
+        for (length_t i = m_pending; i < m_size; i++) {
+            m_storage[i].~T();
+        }
+        m_pending = 0;
+    }
+    /// Return the old buffer, whose items have all been relocated or destroyed, to the allocator.
+    void release_old()
+    {
+        if (m_old) {
+            alloc_traits::deallocate(m_allocator, m_old, m_old_capacity);
+            m_old = nullptr;
+            m_old_capacity = 0;
+        }
+    }
+    /// Exchange the contents of two arrays, but not their allocators.
+    void swap_storage(incremental_dynamic_array &other)
+    {
+        using std::swap;
+        swap(m_storage, other.m_storage);
+        swap(m_capacity, other.m_capacity);
+        swap(m_size, other.m_size);
+        swap(m_old, other.m_old);
+        swap(m_old_capacity, other.m_old_capacity);
+        swap(m_pending, other.m_pending);
+        swap(m_step, other.m_step);
+    }
+
+    /// The buffer all items end up in; it holds the items from m_pending to m_size.
+    T *m_storage;
+    length_t m_capacity;
+    length_t m_size;
+    /// The buffer items are migrating from, holding the items below m_pending (or nullptr).
+    T *m_old;
+    length_t m_old_capacity;
+    length_t m_pending;
+    /// The number of items to relocate per operation during the current migration.
+    length_t m_step;
+    allocator_type m_allocator;
+};
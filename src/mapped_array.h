@@ -0,0 +1,373 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "array_algorithms.h"
+#include "array_view.h"
+#include "growth_policy.h"
+
+/**
+ * \brief A dynamic array of trivially copyable items stored in a memory-mapped file (POSIX).
+ *
+ * The file starts with a small header (format version, item size, size and capacity) followed
+ * by the items, and the whole file is mapped shared: data() points straight into the mapping, and
+ * reopening the file makes the items available at once, without reading or deserializing them.
+ * The size lives in the mapped header, so it is persisted along with the items.
+ *
+ * Growing follows the growth policy G, like dynamic_array, by extending the file with ftruncate()
+ * and remapping it (with mremap() on Linux, which may move the mapping without copying); as with
+ * dynamic_array, this invalidates pointers and references to the items. The items are written
+ * back to the file by the kernel at its own pace; flush() forces this (msync()), and advise()
+ * passes the expected access pattern on to the kernel (madvise()).
+ *
+ * The file holds native binary values, so it can only be reopened on a machine with the same
+ * endianness and layout of T. Two mapped_array objects must not map the same file at once.
+ */
+
+/// Access patterns for mapped_array::advise().
+enum class access_pattern {
+    normal,
+    sequential,
+    random,
+    will_need,
+    dont_need
+};
+
+template <typename T, typename L = unsigned int, typename G = doubling_growth>
+class mapped_array {
+    static_assert(std::is_trivially_copyable<T>::value, "mapped_array requires a trivially copyable type");
+public:
+    using length_t = L;
+    using growth_policy = G;
+
+    /// Version of the file format.
+    static const std::uint32_t version = 1;
+    /// Offset of the first item in the file; also the maximum alignment of T.
+    static const std::size_t data_offset = 64;
+    static_assert(alignof(T) <= data_offset, "the alignment of T exceeds the alignment of the items in the file");
+
+    /// Open the array stored in the file at 'path', creating an empty one if the file does not
+    /// exist or is empty. Throws std::system_error if the file cannot be opened or mapped, and
+    /// std::runtime_error if it does not hold an array of items of this size.
+    explicit mapped_array(const std::string &path)
+        : m_fd(-1), m_mapping(nullptr), m_mapped_bytes(0)
+    {
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (m_fd < 0) {
+            throw_error("open");
+        }
+        try {
+            struct stat st;
+            if (::fstat(m_fd, &st) < 0) {
+                throw_error("fstat");
+            }
+            if (st.st_size == 0) {
+                resize_file(data_offset);
+                map(data_offset);
+                header() = file_header{};
+                std::memcpy(header().magic, magic(), sizeof(header().magic));
+                header().version = version;
+                header().item_size = sizeof(T);
+            }
+            else {
+                if (std::size_t(st.st_size) < data_offset) {
+                    throw std::runtime_error("mapped_array: file too short");
+                }
+                map(std::size_t(st.st_size));
+                check_header();
+            }
+        }
+        catch (...) {
+            release();
+            throw;
+        }
+    }
+    mapped_array(const mapped_array &) = delete;
+    mapped_array &operator=(const mapped_array &) = delete;
+    /// Move-constructor; takes over the mapping of another array.
+    mapped_array(mapped_array &&other) noexcept
+        : m_fd(other.m_fd), m_mapping(other.m_mapping), m_mapped_bytes(other.m_mapped_bytes)
+    {
+        other.m_fd = -1;
+        other.m_mapping = nullptr;
+        other.m_mapped_bytes = 0;
+    }
+    /// Move-assignment operator.
+    mapped_array &operator=(mapped_array &&other)
+    {
+        if (this != &other) {
+            release();
+            std::swap(m_fd, other.m_fd);
+            std::swap(m_mapping, other.m_mapping);
+            std::swap(m_mapped_bytes, other.m_mapped_bytes);
+        }
+        return *this;
+    }
+    /// Destructor; unmaps the file (the kernel still writes back any modified pages).
+    ~mapped_array()
+    { release(); }
+    /// Add an element to the end (by value, since growing may move the mapping).
+    void push_back(T element)
+    {
+        if (size() + 1 > capacity()) {
+            grow(growth_policy::template next_capacity<T>(capacity(), length_t(size() + 1)));
+        }
+        new (data() + size()) T(element);
+        header().size++;
+    }
+    /// Construct an element in-place at the end. Return reference to the element.
+    template <typename ...Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (size() + 1 > capacity()) {
+            grow(growth_policy::template next_capacity<T>(capacity(), length_t(size() + 1)));
+        }
+        T *item = new (data() + size()) T(std::forward<Args>(args)...);
+        header().size++;
+        return *item;
+    }
+    /// Append copies of 'count' items starting at 'items' with a single memcpy. The items may
+    /// belong to the array itself.
+    void append(const T *items, length_t count)
+    {
+        if (size() + count > capacity()) {
+            bool inside = items >= data() && items < data() + size();
+            std::ptrdiff_t offset = inside ? items - data() : 0;
+            grow(growth_policy::template next_capacity<T>(capacity(), length_t(size() + count)));
+            if (inside) {
+                items = data() + offset;
+            }
+        }
+        array_algorithms::uninitialized_copy(data() + size(), items, count);
+        header().size += count;
+    }
+    /// Make sure the array can hold at least 'capacity' items without growing the file.
+    void reserve(length_t capacity)
+    {
+        if (capacity > this->capacity()) {
+            grow(capacity);
+        }
+    }
+    /// Resize the array without initializing the new items, e.g. right before overwriting them
+    /// through data().
+    void resize_uninitialized(length_t size)
+    {
+        reserve(size);
+        header().size = size;
+    }
+    /// Delete the last element.
+    void pop_back()
+    {
+        check_index(size() - 1);
+        header().size--;
+    }
+    /// Clear the array; the file keeps its capacity.
+    void clear()
+    {
+        header().size = 0;
+    }
+    /// Return the size of the array (number of items contained).
+    length_t size() const
+    {
+        return length_t(header().size);
+    }
+    /// Return the capacity of the array, i.e. the number of items the file can hold.
+    length_t capacity() const
+    {
+        return length_t(header().capacity);
+    }
+    /// Return (a reference to) the element at position 'index'; throws std::out_of_range if index >= size.
+    T &operator[](length_t index)
+    {
+        check_index(index);
+        return data()[index];
+    }
+    const T &operator[](length_t index) const
+    {
+        check_index(index);
+        return data()[index];
+    }
+    /// Return raw access to the items, pointing into the mapping.
+    T *data()
+    {
+        return reinterpret_cast<T*>(m_mapping + data_offset);
+    }
+    const T *data() const
+    {
+        return reinterpret_cast<const T*>(m_mapping + data_offset);
+    }
+    /// Return a view of all the items.
+    array_view<T, L> view()
+    {
+        return array_view<T, L>(data(), size());
+    }
+    array_view<const T, L> view() const
+    {
+        return array_view<const T, L>(data(), size());
+    }
+    /// Convert to a view of all the items, e.g. to pass the array to a function taking a view.
+    operator array_view<T, L>()
+    {
+        return view();
+    }
+    operator array_view<const T, L>() const
+    {
+        return view();
+    }
+    /// Perform a linear search for an item equal to 'value'; return its index, or size() if it is
+    /// not found.
+    length_t linearSearch(const T &value) const
+    {
+        return view().linearSearch(value);
+    }
+    /// Perform a binary search on items sorted by operator<; see dynamic_array::binarySearch().
+    length_t binarySearch(const T &value) const
+    {
+        return view().binarySearch(value);
+    }
+    /// Return the number of items equal to 'value'.
+    length_t count(const T &value) const
+    {
+        return view().count(value);
+    }
+    /// Write the modified pages (items and header) back to the file; waits for the writes to
+    /// complete unless 'async' is set.
+    void flush(bool async = false)
+    {
+        if (::msync(m_mapping, m_mapped_bytes, async ? MS_ASYNC : MS_SYNC) < 0) {
+            throw_error("msync");
+        }
+    }
+    /// Tell the kernel how the items are going to be accessed, e.g. access_pattern::sequential
+    /// for a full scan (aggressive read-ahead) or random for lookups (no read-ahead).
+    void advise(access_pattern pattern)
+    {
+        if (::madvise(m_mapping, m_mapped_bytes, advice(pattern)) < 0) {
+            throw_error("madvise");
+        }
+    }
+protected:
+    /// The file header, occupying the first data_offset bytes.
+    struct file_header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t item_size;
+        std::uint64_t size;
+        std::uint64_t capacity;
+    };
+    static_assert(sizeof(file_header) <= data_offset, "the header must fit before the items");
+
+    static const char *magic()
+    {
+        return "CNTRMAP";
+    }
+    static int advice(access_pattern pattern)
+    {
+        switch (pattern) {
+        case access_pattern::sequential: return MADV_SEQUENTIAL;
+        case access_pattern::random: return MADV_RANDOM;
+        case access_pattern::will_need: return MADV_WILLNEED;
+        case access_pattern::dont_need: return MADV_DONTNEED;
+        default: return MADV_NORMAL;
+        }
+    }
+    [[noreturn]] static void throw_error(const char *what)
+    {
+        throw std::system_error(errno, std::generic_category(), std::string("mapped_array: ") + what);
+    }
+    /// Check an index is within range
+    void check_index(length_t index) const
+    {
+        if (index >= size()) {
+            throw std::out_of_range("index out of range");
+        }
+    }
+    file_header &header()
+    {
+        return *reinterpret_cast<file_header*>(m_mapping);
+    }
+    const file_header &header() const
+    {
+        return *reinterpret_cast<const file_header*>(m_mapping);
+    }
+    void check_header() const
+    {
+        const file_header &h = header();
+        if (std::memcmp(h.magic, magic(), sizeof(h.magic)) != 0 || h.version != version) {
+            throw std::runtime_error("mapped_array: not an array file of a supported version");
+        }
+        if (h.item_size != sizeof(T)) {
+            throw std::runtime_error("mapped_array: the file holds items of a different size");
+        }
+        if (h.size > h.capacity || h.capacity > std::uint64_t(length_t(-1)) ||
+            data_offset + h.capacity * sizeof(T) > m_mapped_bytes) {
+            throw std::runtime_error("mapped_array: corrupt header");
+        }
+    }
+    void resize_file(std::size_t bytes)
+    {
+        if (::ftruncate(m_fd, off_t(bytes)) < 0) {
+            throw_error("ftruncate");
+        }
+    }
+    void map(std::size_t bytes)
+    {
+        void *mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (mapping == MAP_FAILED) {
+            throw_error("mmap");
+        }
+        m_mapping = static_cast<unsigned char*>(mapping);
+        m_mapped_bytes = bytes;
+    }
+    /// Extend the file to hold 'capacity' items and remap it.
+    void grow(length_t capacity)
+    {
+        std::size_t bytes = data_offset + std::size_t(capacity) * sizeof(T);
+        resize_file(bytes);
+#ifdef __linux__
+        void *mapping = ::mremap(m_mapping, m_mapped_bytes, bytes, MREMAP_MAYMOVE);
+        if (mapping == MAP_FAILED) {
+            throw_error("mremap");
+        }
+        m_mapping = static_cast<unsigned char*>(mapping);
+        m_mapped_bytes = bytes;
+#else
+        unsigned char *old = m_mapping;
+        std::size_t old_bytes = m_mapped_bytes;
+        map(bytes);
+        ::munmap(old, old_bytes);
+#endif
+        header().capacity = capacity;
+    }
+    void release()
+    {
+        if (m_mapping) {
+            ::munmap(m_mapping, m_mapped_bytes);
+            m_mapping = nullptr;
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+private:
+    int m_fd;
+    unsigned char *m_mapping;
+    std::size_t m_mapped_bytes;
+};
+
+template <typename T, typename L, typename G>
+const std::uint32_t mapped_array<T, L, G>::version;
+template <typename T, typename L, typename G>
+const std::size_t mapped_array<T, L, G>::data_offset;
@@ -0,0 +1,306 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#include "aligned_allocator.h"
+
+/**
+ * \brief Where the pages of large blocks are placed on a NUMA machine.
+ *
+ *  - system_default: the policy of the calling thread (usually first touch), left untouched.
+ *  - first_touch: each page on the node of the thread that first writes it (MPOL_LOCAL), so
+ *    workers initializing their own part of an array get it on their own node.
+ *  - interleave: pages spread round-robin over the nodes, so that threads on every socket see
+ *    the same average bandwidth and no node's memory controller becomes the bottleneck.
+ *  - bind: pages only on the given nodes, e.g. the node of the threads using the array.
+ */
+enum class numa_policy {
+    system_default,
+    first_touch,
+    interleave,
+    bind
+};
+
+/**
+ * \brief The pages backing large blocks.
+ *
+ *  - normal: base pages (4 KB on x86-64).
+ *  - transparent_huge: base-page mappings aligned to 2 MB and marked MADV_HUGEPAGE, so that the
+ *    kernel backs them with transparent huge pages when it can (even if THP is set to
+ *    "madvise" only).
+ *  - huge_2mb, huge_1gb: explicit huge pages from the pools reserved in
+ *    /sys/kernel/mm/hugepages; if the pool runs dry the block falls back to transparent_huge.
+ */
+enum class page_kind {
+    normal,
+    transparent_huge,
+    huge_2mb,
+    huge_1gb
+};
+
+/**
+ * \brief The placement of the blocks of a numa_allocator: a NUMA policy over a set of nodes, the
+ * page kind, and the size from which blocks are mapped with them.
+ *
+ *     numa_allocator<float> alloc(memory_placement::interleaved().with_pages(page_kind::transparent_huge));
+ *     dynamic_array<float, std::size_t, numa_allocator<float>> samples(alloc);
+ */
+struct memory_placement {
+    numa_policy policy;
+    /// Bit i selects node i (nodes 0 to 63); 0 selects all the nodes the process may use.
+    std::uint64_t nodes;
+    page_kind pages;
+    /// Smaller blocks come from malloc (see aligned_allocator), since mapping them would waste
+    /// most of a page and a system call per allocation.
+    std::size_t min_bytes;
+
+    memory_placement(numa_policy policy = numa_policy::system_default, std::uint64_t nodes = 0,
+                     page_kind pages = page_kind::normal, std::size_t min_bytes = default_min_bytes)
+        : policy(policy), nodes(nodes), pages(pages), min_bytes(min_bytes)
+    {}
+    static memory_placement first_touch()
+    {
+        return memory_placement(numa_policy::first_touch);
+    }
+    static memory_placement interleaved(std::uint64_t nodes = 0)
+    {
+        return memory_placement(numa_policy::interleave, nodes);
+    }
+    static memory_placement bound_to(unsigned int node)
+    {
+        return memory_placement(numa_policy::bind, std::uint64_t(1) << node);
+    }
+    memory_placement with_pages(page_kind kind) const
+    {
+        memory_placement p = *this;
+        p.pages = kind;
+        return p;
+    }
+    bool operator==(const memory_placement &other) const
+    {
+        return policy == other.policy && nodes == other.nodes && pages == other.pages &&
+               min_bytes == other.min_bytes;
+    }
+    bool operator!=(const memory_placement &other) const
+    {
+        return !(*this == other);
+    }
+
+    static const std::size_t default_min_bytes = std::size_t(1) << 20;
+};
+
+/**
+ * \brief An allocator placing large blocks on NUMA nodes and huge pages as a memory_placement
+ * says (Linux only).
+ *
+ * Blocks of at least placement.min_bytes are anonymous mappings of their own, rounded up to the
+ * page size, to which the NUMA policy is applied with mbind() before any page is touched; smaller
+ * blocks come from an aligned_allocator<T>. The placement is a hint: if the kernel rejects it
+ * (e.g. without NUMA support), the block keeps the default policy.
+ *
+ * reallocate() (see allocator_has_reallocate) resizes mapped blocks with mremap(), which moves
+ * the page tables rather than the bytes, and keeps the policy of the mapping; blocks crossing
+ * min_bytes, and blocks of explicit huge pages, which mremap cannot always resize, are
+ * reallocated by the array instead.
+ *
+ * The allocator holds its placement: allocators compare equal if their placements do, and the
+ * placement propagates along with the storage on copy, move and swap.
+ */
+template <typename T>
+class numa_allocator {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    template <typename U>
+    struct rebind {
+        using other = numa_allocator<U>;
+    };
+
+    numa_allocator(const memory_placement &placement = memory_placement())
+        : m_placement(placement)
+    {}
+    template <typename U>
+    numa_allocator(const numa_allocator<U> &other)
+        : m_placement(other.placement())
+    {}
+    /// Return the placement of the blocks.
+    const memory_placement &placement() const
+    {
+        return m_placement;
+    }
+    /// Allocate uninitialized storage for n objects of type T.
+    T *allocate(std::size_t n)
+    {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        if (!mapped(n * sizeof(T))) {
+            return small().allocate(n);
+        }
+        return static_cast<T*>(map(n * sizeof(T)));
+    }
+    /// Release storage previously returned by allocate().
+    void deallocate(T *ptr, std::size_t n)
+    {
+        if (!mapped(n * sizeof(T))) {
+            small().deallocate(ptr, n);
+        }
+        else {
+            ::munmap(ptr, mapping_size(n * sizeof(T)));
+        }
+    }
+    /// Resize storage for 'old_n' objects to hold 'new_n' objects; see aligned_allocator::reallocate().
+    T *reallocate(T *ptr, std::size_t old_n, std::size_t new_n)
+    {
+        if (new_n > max_size() || mapped(old_n * sizeof(T)) != mapped(new_n * sizeof(T))) {
+            return nullptr;
+        }
+        if (!mapped(new_n * sizeof(T))) {
+            return small().reallocate(ptr, old_n, new_n);
+        }
+        std::size_t old_size = mapping_size(old_n * sizeof(T)), new_size = mapping_size(new_n * sizeof(T));
+        if (old_size == new_size) {
+            return ptr;
+        }
+        if (explicit_huge_pages()) {
+            return nullptr;
+        }
+        // The NUMA policy and the huge page advice belong to the mapping, so the pages added to
+        // it inherit them.
+        void *moved = ::mremap(ptr, old_size, new_size, MREMAP_MAYMOVE);
+        return moved == MAP_FAILED ? nullptr : static_cast<T*>(moved);
+    }
+    /// The maximum number of objects that can be requested by allocate().
+    std::size_t max_size() const
+    {
+        return (static_cast<std::size_t>(-1) - huge_1gb_size) / sizeof(T);
+    }
+
+    template <typename U>
+    bool operator==(const numa_allocator<U> &other) const { return m_placement == other.placement(); }
+    template <typename U>
+    bool operator!=(const numa_allocator<U> &other) const { return !(*this == other); }
+
+private:
+    static constexpr std::size_t page_size = 4096;
+    static constexpr std::size_t huge_2mb_size = std::size_t(1) << 21;
+    static constexpr std::size_t huge_1gb_size = std::size_t(1) << 30;
+    static_assert(alignof(T) <= page_size, "numa_allocator aligns mapped blocks to pages only");
+
+    static aligned_allocator<T> small()
+    {
+        return aligned_allocator<T>();
+    }
+    bool mapped(std::size_t bytes) const
+    {
+        return bytes > 0 && bytes >= m_placement.min_bytes;
+    }
+    bool explicit_huge_pages() const
+    {
+        return m_placement.pages == page_kind::huge_2mb || m_placement.pages == page_kind::huge_1gb;
+    }
+    /// Return the size of the mapping of a block: a whole number of pages of the placement's kind.
+    /// A fallback from explicit huge pages keeps that size, which only costs address space, since
+    /// the pages past the block are never touched.
+    std::size_t mapping_size(std::size_t bytes) const
+    {
+        std::size_t unit = m_placement.pages == page_kind::huge_1gb ? huge_1gb_size
+                         : m_placement.pages == page_kind::normal ? page_size : huge_2mb_size;
+        return (bytes + unit - 1) & ~(unit - 1);
+    }
+    /// Map a block and apply the placement to it; throws std::bad_alloc if it cannot be mapped.
+    void *map(std::size_t bytes) const
+    {
+        std::size_t size = mapping_size(bytes);
+        void *ptr = MAP_FAILED;
+        if (explicit_huge_pages()) {
+            int log2_size = m_placement.pages == page_kind::huge_1gb ? 30 : 21;
+            ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log2_size << huge_shift), -1, 0);
+        }
+        if (ptr == MAP_FAILED) {
+            ptr = map_aligned(size, m_placement.pages == page_kind::normal ? page_size : huge_2mb_size);
+            advise(ptr, size);
+        }
+        bind(ptr, size);
+        return ptr;
+    }
+    /// Map 'size' bytes of base pages aligned to 'alignment', by trimming a larger mapping.
+    static void *map_aligned(std::size_t size, std::size_t alignment)
+    {
+        std::size_t extra = alignment > page_size ? alignment : 0;
+        void *raw = ::mmap(nullptr, size + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        char *start = static_cast<char*>(raw);
+        char *aligned = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(start) + extra) & ~(alignment - 1));
+        if (extra) {
+            if (aligned != start) {
+                ::munmap(start, std::size_t(aligned - start));
+            }
+            if (aligned + size != start + size + extra) {
+                ::munmap(aligned + size, std::size_t(start + size + extra - (aligned + size)));
+            }
+        }
+        return aligned;
+    }
+    /// Ask for transparent huge pages over a range of base pages, if the placement wants any.
+    void advise(void *ptr, std::size_t size) const
+    {
+        if (m_placement.pages != page_kind::normal) {
+            ::madvise(ptr, size, MADV_HUGEPAGE);
+        }
+    }
+    /// Apply the NUMA policy to a range of untouched pages (best effort).
+    void bind(void *ptr, std::size_t size) const
+    {
+        unsigned long mask[2] = {static_cast<unsigned long>(m_placement.nodes), 0};
+        switch (m_placement.policy) {
+        case numa_policy::first_touch:
+            ::syscall(SYS_mbind, ptr, size, MPOL_LOCAL, nullptr, 0, 0);
+            break;
+        case numa_policy::interleave:
+        case numa_policy::bind:
+            if (!mask[0]) {
+                // The nodes the process may use; maxnode counts one more bit than the mask holds.
+                if (::syscall(SYS_get_mempolicy, nullptr, mask, 65, nullptr, MPOL_F_MEMS_ALLOWED) != 0 || !mask[0]) {
+                    return;
+                }
+            }
+            ::syscall(SYS_mbind, ptr, size, m_placement.policy == numa_policy::bind ? MPOL_BIND : MPOL_INTERLEAVE,
+                      mask, 65, 0);
+            break;
+        default:
+            break;
+        }
+    }
+
+#ifdef MAP_HUGE_SHIFT
+    static constexpr int huge_shift = MAP_HUGE_SHIFT;
+#else
+    static constexpr int huge_shift = 26;
+#endif
+
+    memory_placement m_placement;
+};
+
+template <typename T>
+constexpr std::size_t numa_allocator<T>::page_size;
+template <typename T>
+constexpr std::size_t numa_allocator<T>::huge_2mb_size;
+template <typename T>
+constexpr std::size_t numa_allocator<T>::huge_1gb_size;
+template <typename T>
+constexpr int numa_allocator<T>::huge_shift;
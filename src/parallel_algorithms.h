@@ -0,0 +1,490 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "array_algorithms.h"
+
+/**
+ * \brief Parallel versions of a few standard algorithms on random-access ranges, e.g. the
+ * begin()/end() iterators of the arrays and of array_view, for C++14 code without std::execution:
+ *
+ *     parallel_algorithms::sort(array.begin(), array.end());
+ *     parallel_algorithms::for_each(array.begin(), array.end(), [](T &item) { ... });
+ *     double total = parallel_algorithms::reduce(view.begin(), view.end(), 0.0);
+ *     auto last = parallel_algorithms::copy_if(array.begin(), array.end(), out.begin(), is_odd);
+ *
+ * The work runs on thread_pool::shared(): the calling thread and up to 'threads' - 1 workers
+ * ('threads' = 0 for std::thread::hardware_concurrency()), with at least min_items_per_thread
+ * items per thread, so small ranges run on the calling thread alone. Each thread starts with a
+ * contiguous chunk of the range and takes items from it a grain at a time; a thread done with
+ * its chunk steals half of the rest of another one, so uneven work (per item, or between
+ * threads) is balanced. Functions, predicates and comparators are called concurrently from
+ * several threads. If any call throws, the algorithm stops handing out work, waits for all
+ * threads and rethrows the first exception; the range (or output) is then left in a valid but
+ * unspecified state.
+ */
+namespace parallel_algorithms {
+
+/// The smallest chunk worth handing to a thread of its own.
+const std::size_t min_items_per_thread = 4096;
+
+/// The fewest items a thread takes from its chunk at once, amortizing the cost of taking them.
+const std::size_t min_grain = 1024;
+
+/**
+ * \brief A pool of worker threads running loops over index ranges with work stealing.
+ *
+ * parallel_for() splits [0, count) into one contiguous chunk per thread taking part, the
+ * calling thread included. Each thread repeatedly takes the next 'grain' indices of its own
+ * chunk (under a lock of that chunk, which is rarely contended), and once its chunk is empty
+ * steals the back half of the chunk of another thread, until all chunks are empty.
+ *
+ * Workers are started when the pool is created and whenever a loop asks for more threads than
+ * the pool has; they sleep on a condition variable between loops, so a loop costs a wake-up
+ * instead of a thread creation. Loops started concurrently from several threads, or nested in
+ * the body of a loop, share the workers: each worker joins any loop that has a chunk without a
+ * thread, and a caller waiting for the last calls of its loop helps the other loops meanwhile.
+ * A loop never waits for a free worker (its caller steals the chunks no worker took), so
+ * nesting cannot deadlock.
+ */
+class thread_pool {
+public:
+    /// Construct a pool and start 'workers' worker threads.
+    explicit thread_pool(unsigned int workers = 0)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        add_workers(workers);
+    }
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+    /// Stop and join the workers; no loop must be running.
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_changed.notify_all();
+        for (std::thread &worker : m_workers) {
+            worker.join();
+        }
+    }
+    /// Return the number of worker threads.
+    unsigned int workers()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return unsigned(m_workers.size());
+    }
+    /// Call body(begin, end) over disjoint subranges covering [0, count), on the calling thread
+    /// and up to 'threads' - 1 workers, taking at least 'grain' indices at a time (except at the
+    /// end of a chunk). Wait for all the calls and rethrow the first exception thrown; once a
+    /// call has thrown, no other is started.
+    template <typename Body>
+    void parallel_for(std::size_t count, std::size_t grain, unsigned int threads, const Body &body)
+    {
+        grain = std::max<std::size_t>(grain, 1);
+        std::size_t pieces = (count + grain - 1) / grain;
+        unsigned int n = unsigned(std::min<std::size_t>(std::max(threads, 1u), pieces));
+        if (n <= 1) {
+            if (count) {
+                body(std::size_t(0), count);
+            }
+            return;
+        }
+        job work(count, grain, n, &call<Body>, &body);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            add_workers(n - 1);
+            m_jobs.push_back(&work);
+        }
+        m_changed.notify_all();
+        work.participate(0);
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &work));
+            work.running--;
+            while (work.running) {
+                if (job *other = open_job()) {
+                    join(*other, lock);
+                }
+                else {
+                    m_changed.wait(lock);
+                }
+            }
+        }
+        if (work.error) {
+            std::rethrow_exception(work.error);
+        }
+    }
+    /// Return the pool used by the algorithms; it starts without workers and keeps the ones
+    /// started for the largest number of threads asked for.
+    static thread_pool &shared()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+private:
+    /// The indices [begin, end) not yet taken from the chunk of a thread.
+    struct chunk {
+        std::mutex lock;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        char padding[64];   // keeps the chunks of different threads on different cache lines
+    };
+
+    /// A running loop.
+    struct job {
+        std::vector<chunk> chunks;
+        std::size_t grain;
+        void (*call)(const void *body, std::size_t begin, std::size_t end);
+        const void *body;
+        unsigned int joined = 1;    // threads that took a chunk index, the caller first (under m_mutex)
+        unsigned int running = 1;   // threads still working (under m_mutex)
+        std::atomic<bool> failed;
+        std::mutex error_lock;
+        std::exception_ptr error;
+
+        job(std::size_t count, std::size_t grain, unsigned int n,
+            void (*call)(const void *, std::size_t, std::size_t), const void *body)
+            : chunks(n), grain(grain), call(call), body(body), failed(false)
+        {
+            for (unsigned int i = 0; i < n; i++) {
+                chunks[i].begin = count / n * i + std::min<std::size_t>(count % n, i);
+                chunks[i].end = count / n * (i + 1) + std::min<std::size_t>(count % n, i + 1);
+            }
+        }
+        /// Work as thread 'index' until no chunk has indices left, or a call has thrown.
+        void participate(unsigned int index)
+        {
+            chunk &own = chunks[index];
+            try {
+                while (!failed.load(std::memory_order_relaxed)) {
+                    std::size_t begin, end;
+                    {
+                        std::lock_guard<std::mutex> lock(own.lock);
+                        begin = own.begin;
+                        end = std::min(own.end, begin + grain);
+                        own.begin = end;
+                    }
+                    if (begin < end) {
+                        call(body, begin, end);
+                    }
+                    else if (!steal(index)) {
+                        break;
+                    }
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(error_lock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+        /// Move the back half of the first non-empty chunk after 'index' (all of it, if no more
+        /// than a grain is left) into the chunk of 'index'; return false if all chunks are empty.
+        bool steal(unsigned int index)
+        {
+            unsigned int n = unsigned(chunks.size());
+            for (unsigned int k = 1; k < n; k++) {
+                chunk &victim = chunks[(index + k) % n];
+                std::size_t begin, end;
+                {
+                    std::lock_guard<std::mutex> lock(victim.lock);
+                    if (victim.begin == victim.end) {
+                        continue;
+                    }
+                    std::size_t left = victim.end - victim.begin;
+                    begin = left > grain ? victim.end - left / 2 : victim.begin;
+                    end = victim.end;
+                    victim.end = begin;
+                }
+                std::lock_guard<std::mutex> lock(chunks[index].lock);
+                chunks[index].begin = begin;
+                chunks[index].end = end;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    template <typename Body>
+    static void call(const void *body, std::size_t begin, std::size_t end)
+    {
+        (*static_cast<const Body*>(body))(begin, end);
+    }
+
+    /// Start workers until there are at least 'count' (under m_mutex).
+    void add_workers(unsigned int count)
+    {
+        while (m_workers.size() < count) {
+            m_workers.emplace_back([this] { work(); });
+        }
+    }
+    /// Return the first running loop that still has a chunk without a thread, or null (under
+    /// m_mutex).
+    job *open_job() const
+    {
+        for (job *work : m_jobs) {
+            if (work->joined < work->chunks.size()) {
+                return work;
+            }
+        }
+        return nullptr;
+    }
+    /// Take the next chunk index of 'work' and work on it, with 'lock' released meanwhile.
+    void join(job &work, std::unique_lock<std::mutex> &lock)
+    {
+        unsigned int index = work.joined++;
+        work.running++;
+        lock.unlock();
+        work.participate(index);
+        lock.lock();
+        if (--work.running == 0) {
+            m_changed.notify_all();
+        }
+    }
+    /// The loop of a worker: join each loop that still has a chunk without a thread.
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_changed.wait(lock, [this] { return m_stop || open_job(); });
+            if (m_stop) {
+                return;
+            }
+            join(*open_job(), lock);
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;  // a loop started, or its last thread finished
+    std::vector<std::thread> m_workers;
+    std::vector<job*> m_jobs;           // the running loops, oldest first
+    bool m_stop = false;
+};
+
+namespace detail {
+
+/// Return the number of threads to use for 'count' items.
+inline unsigned int thread_count(std::size_t count, unsigned int threads)
+{
+    if (!threads) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    std::size_t useful = std::max<std::size_t>(count / min_items_per_thread, 1);
+    return unsigned(std::min<std::size_t>(threads, useful));
+}
+
+/// Return the grain for 'count' items on n threads: about 8 grains per chunk, so that a thread
+/// finishing early finds work to steal, and at least min_grain.
+inline std::size_t grain_size(std::size_t count, unsigned int n)
+{
+    return std::max(count / (8 * std::size_t(n)), min_grain);
+}
+
+/// Return the size of the blocks into which reduce() and copy_if() split 'count' items: it
+/// depends on 'count' only, so that the results do not depend on the number of threads. It is
+/// a multiple of 64, so that the bits of different blocks are in different words.
+inline std::size_t block_size(std::size_t count)
+{
+    std::size_t size = std::max<std::size_t>((count + 1023) / 1024, min_grain);
+    return (size + 63) / 64 * 64;
+}
+
+/// Call f(begin, end) over subranges covering [0, count) on the shared pool, with n threads.
+template <typename Function>
+void parallel_for(std::size_t count, unsigned int n, const Function &f)
+{
+    thread_pool::shared().parallel_for(count, grain_size(count, n), n, f);
+}
+
+/// Run task(i) for i in [0, n), on n threads (task 0 on the calling thread at first); wait for
+/// all of them and rethrow the first exception thrown.
+template <typename Task>
+void run(unsigned int n, const Task &task)
+{
+    thread_pool::shared().parallel_for(n, 1, n, [&task](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            task(unsigned(i));
+        }
+    });
+}
+
+/// Return the start of chunk i when splitting 'count' items into n chunks.
+inline std::size_t chunk_start(std::size_t count, unsigned int n, unsigned int i)
+{
+    return count / n * i + std::min<std::size_t>(count % n, i);
+}
+
+/// Sort a chunk: contiguous items by operator< go through array_algorithms::sort() (a radix sort
+/// for integers and floats), anything else through std::sort.
+template <typename Iterator, typename Compare>
+void sort_chunk(Iterator first, Iterator last, Compare comp)
+{
+    std::sort(first, last, comp);
+}
+
+template <typename T>
+void sort_chunk(T *first, T *last, std::less<T>)
+{
+    array_algorithms::sort(first, std::size_t(last - first));
+}
+
+} // namespace detail
+
+/// Call f(item) for every item of the range [first, last), on several threads.
+template <typename Iterator, typename Function>
+void for_each(Iterator first, Iterator last, Function f, unsigned int threads = 0)
+{
+    std::size_t count = std::size_t(last - first);
+    detail::parallel_for(count, detail::thread_count(count, threads), [&](std::size_t begin, std::size_t end) {
+        std::for_each(first + begin, first + end, f);
+    });
+}
+
+/// Assign f(item) for every item of the range [first, last) to the item at the same position
+/// of the range starting at 'out' (which may be 'first'), on several threads; return the end of
+/// the output.
+template <typename Iterator, typename OutputIterator, typename Function>
+OutputIterator transform(Iterator first, Iterator last, OutputIterator out, Function f, unsigned int threads = 0)
+{
+    std::size_t count = std::size_t(last - first);
+    detail::parallel_for(count, detail::thread_count(count, threads), [&](std::size_t begin, std::size_t end) {
+        std::transform(first + begin, first + end, out + begin, f);
+    });
+    return out + count;
+}
+
+/// Return init combined with all the items of the range [first, last) by 'op', which must be
+/// associative (but not necessarily commutative), on several threads. The items are combined in
+/// blocks whose partial results are combined in order, so the result is the same for any number
+/// of threads, though it may differ (e.g. by rounding) from a sequential left fold.
+template <typename Iterator, typename T, typename BinaryOperation>
+T reduce(Iterator first, Iterator last, T init, BinaryOperation op, unsigned int threads = 0)
+{
+    std::size_t count = std::size_t(last - first);
+    std::size_t block = detail::block_size(count);
+    std::size_t blocks = (count + block - 1) / block;
+    std::vector<T> partials(blocks, init);
+    thread_pool::shared().parallel_for(blocks, 1, detail::thread_count(count, threads), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; k++) {
+            Iterator item = first + k * block;
+            Iterator block_end = first + std::min(count, (k + 1) * block);
+            T partial = *item;
+            for (++item; item != block_end; ++item) {
+                partial = op(std::move(partial), *item);
+            }
+            partials[k] = std::move(partial);
+        }
+    });
+    for (T &partial : partials) {
+        init = op(std::move(init), std::move(partial));
+    }
+    return init;
+}
+
+/// Return init plus the sum of the items of the range [first, last) (see above).
+template <typename Iterator, typename T>
+T reduce(Iterator first, Iterator last, T init)
+{
+    return parallel_algorithms::reduce(first, last, std::move(init), std::plus<T>());
+}
+
+/// Assign the items of the range [first, last) satisfying 'pred', in order, to the range
+/// starting at 'out', which must be pre-sized (e.g. to last - first items) and must not overlap
+/// the input; return the end of the items assigned. Each thread assigns the items of its blocks
+/// at offsets computed up front, so outputs are never contended: a first pass evaluates 'pred'
+/// once per item (keeping one bit per item) and counts the items of each block, a second copies.
+template <typename Iterator, typename OutputIterator, typename Predicate>
+OutputIterator copy_if(Iterator first, Iterator last, OutputIterator out, Predicate pred, unsigned int threads = 0)
+{
+    std::size_t count = std::size_t(last - first);
+    std::size_t block = detail::block_size(count);
+    std::size_t blocks = (count + block - 1) / block;
+    unsigned int n = detail::thread_count(count, threads);
+    if (n == 1) {
+        return std::copy_if(first, last, out, pred);
+    }
+    std::vector<std::uint64_t> selected((count + 63) / 64);
+    std::vector<std::size_t> offsets(blocks + 1);
+    thread_pool::shared().parallel_for(blocks, 1, n, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; k++) {
+            std::size_t found = 0;
+            for (std::size_t i = k * block; i < std::min(count, (k + 1) * block); i += 64) {
+                std::uint64_t bits = 0;
+                Iterator item = first + i;
+                for (unsigned int j = 0, width = unsigned(std::min<std::size_t>(64, count - i)); j < width; j++, ++item) {
+                    bits |= std::uint64_t(bool(pred(*item))) << j;
+                }
+                selected[i / 64] = bits;
+                found += std::size_t(__builtin_popcountll(bits));
+            }
+            offsets[k + 1] = found;
+        }
+    });
+    for (std::size_t k = 0; k < blocks; k++) {
+        offsets[k + 1] += offsets[k];
+    }
+    thread_pool::shared().parallel_for(blocks, 1, n, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; k++) {
+            OutputIterator to = out + offsets[k];
+            for (std::size_t i = k * block; i < std::min(count, (k + 1) * block); i += 64) {
+                for (std::uint64_t bits = selected[i / 64]; bits; bits &= bits - 1) {
+                    *to = first[i + std::size_t(__builtin_ctzll(bits))];
+                    ++to;
+                }
+            }
+        }
+    });
+    return out + offsets[blocks];
+}
+
+/// Sort the range [first, last) by 'comp' (not stably), on several threads: each thread sorts
+/// a chunk, then neighbouring chunks are merged pairwise, the merges of a round in parallel.
+template <typename Iterator, typename Compare>
+void sort(Iterator first, Iterator last, Compare comp, unsigned int threads = 0)
+{
+    std::size_t count = std::size_t(last - first);
+    unsigned int n = detail::thread_count(count, threads);
+    std::vector<std::size_t> bounds(n + 1);
+    for (unsigned int i = 0; i <= n; i++) {
+        bounds[i] = detail::chunk_start(count, n, i);
+    }
+    detail::run(n, [&](unsigned int i) {
+        detail::sort_chunk(first + bounds[i], first + bounds[i + 1], comp);
+    });
+    // Each round merges chunks 2k and 2k+1, halving the number of chunks.
+    while (bounds.size() > 2) {
+        unsigned int merges = unsigned(bounds.size() - 1) / 2;
+        detail::run(merges, [&](unsigned int k) {
+            std::inplace_merge(first + bounds[2 * k], first + bounds[2 * k + 1], first + bounds[2 * k + 2], comp);
+        });
+        std::vector<std::size_t> merged;
+        for (std::size_t i = 0; i < bounds.size(); i += 2) {
+            merged.push_back(bounds[i]);
+        }
+        if (merged.back() != count) {
+            merged.push_back(count);
+        }
+        bounds.swap(merged);
+    }
+}
+
+/// Sort the range [first, last) by operator<, on hardware_concurrency() threads.
+template <typename Iterator>
+void sort(Iterator first, Iterator last)
+{
+    parallel_algorithms::sort(first, last, std::less<typename std::iterator_traits<Iterator>::value_type>());
+}
+
+} // namespace parallel_algorithms
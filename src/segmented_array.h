@@ -0,0 +1,422 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "aligned_allocator.h"
+#include "array_algorithms.h"
+#include "array_view.h"
+#include "dynamic_array.h"
+
+/**
+ * \brief A dynamic array stored in fixed-size chunks of 2^B items, which never relocates items.
+ *
+ * The items live in chunks allocated separately, and a directory (a dynamic_array of pointers)
+ * lists the chunks in order; item i is item (i & (2^B - 1)) of chunk (i >> B). Growing allocates
+ * one more chunk and appends its pointer to the directory, so:
+ *  - a push_back() never copies items: its worst case is one chunk allocation (plus, rarely,
+ *    growing the directory, which holds one pointer per 2^B items), instead of relocating the
+ *    whole array into a block twice its size;
+ *  - no contiguous block larger than a chunk is ever needed;
+ *  - pointers and references to items stay valid until the items are deleted.
+ *
+ * Chunks emptied by pop_back(), swap_remove() or clear() stay in the directory, after the chunks
+ * in use, and still count in capacity(), so later pushes fill them again before another chunk is
+ * allocated; shrink_to_fit() returns them to the allocator.
+ *
+ * Indexing costs a shift, a mask and one more indirection than dynamic_array. The items of each
+ * chunk are contiguous, so chunk(k) returns a view of them to process chunk by chunk, and the
+ * searches run the (vectorized) searches of array_algorithms.h on each chunk. The iterators are
+ * random access, so the standard algorithms (e.g. std::sort) work on the whole array.
+ *
+ * The chunks are obtained from an allocator of type A, rebound to T; it is copied along with the
+ * array and moved along with its chunks.
+ */
+
+template <typename T, typename L = unsigned int, unsigned int B = 10, typename A = aligned_allocator<T>>
+class segmented_array {
+    using alloc_traits = typename std::allocator_traits<A>::template rebind_traits<T>;
+    static_assert(B < sizeof(L) * 8, "a chunk must be smaller than the maximum size");
+public:
+    using length_t = L;
+    using allocator_type = typename alloc_traits::allocator_type;
+    using value_type = T;
+
+    /// Number of items in a chunk.
+    static constexpr length_t chunk_size = length_t(1) << B;
+
+    /// A random-access iterator over the items; U is T or const T.
+    template <typename U>
+    class basic_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename std::remove_const<U>::type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = U*;
+        using reference = U&;
+
+        basic_iterator()
+            : m_chunks(nullptr), m_index(0)
+        {}
+        basic_iterator(const dynamic_array<T*, L> *chunks, length_t index)
+            : m_chunks(chunks), m_index(index)
+        {}
+        /// Convert an iterator into a const iterator.
+        operator basic_iterator<const T>() const
+        {
+            return basic_iterator<const T>(m_chunks, m_index);
+        }
+        reference operator*() const { return m_chunks->data()[m_index >> B][m_index & (chunk_size - 1)]; }
+        pointer operator->() const { return &**this; }
+        reference operator[](difference_type n) const { return *(*this + n); }
+        basic_iterator &operator++() { m_index++; return *this; }
+        basic_iterator &operator--() { m_index--; return *this; }
+        basic_iterator operator++(int) { basic_iterator old = *this; m_index++; return old; }
+        basic_iterator operator--(int) { basic_iterator old = *this; m_index--; return old; }
+        basic_iterator &operator+=(difference_type n) { m_index = length_t(m_index + n); return *this; }
+        basic_iterator &operator-=(difference_type n) { m_index = length_t(m_index - n); return *this; }
+        basic_iterator operator+(difference_type n) const { return basic_iterator(m_chunks, length_t(m_index + n)); }
+        basic_iterator operator-(difference_type n) const { return basic_iterator(m_chunks, length_t(m_index - n)); }
+        friend basic_iterator operator+(difference_type n, const basic_iterator &it) { return it + n; }
+        difference_type operator-(const basic_iterator &other) const
+        {
+            return difference_type(m_index) - difference_type(other.m_index);
+        }
+        bool operator==(const basic_iterator &other) const { return m_index == other.m_index; }
+        bool operator!=(const basic_iterator &other) const { return m_index != other.m_index; }
+        bool operator<(const basic_iterator &other) const { return m_index < other.m_index; }
+        bool operator>(const basic_iterator &other) const { return m_index > other.m_index; }
+        bool operator<=(const basic_iterator &other) const { return m_index <= other.m_index; }
+        bool operator>=(const basic_iterator &other) const { return m_index >= other.m_index; }
+    private:
+        // The directory itself rather than its data(), which moves when the directory grows.
+        const dynamic_array<T*, L> *m_chunks;
+        length_t m_index;
+    };
+    using iterator = basic_iterator<T>;
+    using const_iterator = basic_iterator<const T>;
+
+    /// Default constructor; no memory is allocated until the first item is added.
+    segmented_array()
+        : m_size(0)
+    {}
+    /// Construct an empty array using a specific allocator.
+    explicit segmented_array(const allocator_type &alloc)
+        : m_size(0), m_allocator(alloc)
+    {}
+    /// Copy-constructor; performs a copy of the array.
+    segmented_array(const segmented_array &other)
+        : m_size(0), m_allocator(alloc_traits::select_on_container_copy_construction(other.m_allocator))
+    {
+        try {
+            append(other);
+        }
+        catch (...) {
+            clear();
+            release_chunks(0);
+            throw;
+        }
+    }
+    /// Move-constructor; takes over the chunks (and the allocator) of another array.
+    segmented_array(segmented_array &&other) noexcept
+        : m_size(other.m_size), m_chunks(std::move(other.m_chunks)), m_allocator(std::move(other.m_allocator))
+    {
+        other.m_size = 0;
+    }
+    /// Copy-assignment operator; reuses the chunks of the array.
+    segmented_array &operator=(const segmented_array &other)
+    {
+        if (this != &other) {
+            clear();
+            append(other);
+        }
+        return *this;
+    }
+    /// Move-assignment operator; exchanges the chunks (and the allocators) of the arrays.
+    segmented_array &operator=(segmented_array &&other)
+    {
+        swap(*this, other);
+        return *this;
+    }
+    /// Destructor
+    ~segmented_array()
+    {
+        clear();
+        release_chunks(0);
+    }
+    /// Swap two arrays
+    friend void swap(segmented_array &first, segmented_array &second)
+    {
+        using std::swap;
+        swap(first.m_size, second.m_size);
+        swap(first.m_chunks, second.m_chunks);
+        swap(first.m_allocator, second.m_allocator);
+    }
+    /// Return a copy of the allocator used by the array.
+    allocator_type get_allocator() const
+    {
+        return m_allocator;
+    }
+    /// Add an element to the end. Growing never moves items, so the element may belong to the
+    /// array itself.
+    void push_back(const T &element)
+    {
+        emplace_back(element);
+    }
+    void push_back(T &&element)
+    {
+        emplace_back(std::move(element));
+    }
+    /// Construct an element in-place at the end.
+    /// Return reference to the element.
+    template <typename ...Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (m_size == capacity()) {
+            add_chunk();
+        }
+        T *item = new (&at_unchecked(m_size)) T(std::forward<Args>(args)...);
+        m_size++;
+        return *item;
+    }
+    /// Append copies of the items of another array (which may be the array itself).
+    void append(const segmented_array &other)
+    {
+        length_t count = other.m_size;
+        reserve(length_t(m_size + count));
+        for (length_t i = 0; i < count; i++) {
+            new (&at_unchecked(m_size)) T(other.at_unchecked(i));
+            m_size++;
+        }
+    }
+    /// Make sure the array can hold at least 'capacity' items without allocating chunks.
+    void reserve(length_t capacity)
+    {
+        while (this->capacity() < capacity) {
+            add_chunk();
+        }
+    }
+    /// Return the chunks not in use to the allocator.
+    void shrink_to_fit()
+    {
+        release_chunks(chunk_count());
+        m_chunks.shrink_to_fit();
+    }
+    /// Delete the last element.
+    void pop_back()
+    {
+        check_index(m_size - 1);
+        at_unchecked(--m_size).~T();
+    }
+    /// Delete an element by moving the last one on top of it.
+    void swap_remove(length_t index)
+    {
+        check_index(index);
+        array_algorithms::swap_remove(&at_unchecked(index), &at_unchecked(m_size - 1));
+        m_size--;
+    }
+    /// Clear the array by destroying all items; the chunks are kept for reuse.
+    void clear()
+    {
+        for (length_t i = 0; i < m_size; i++) {
+            at_unchecked(i).~T();
+        }
+        m_size = 0;
+    }
+    /// Return the size of the array (number of items contained).
+    length_t size() const
+    {
+        return m_size;
+    }
+    /// Return whether the array holds no items.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+    /// Return the capacity of the array (number of items the allocated chunks can contain).
+    length_t capacity() const
+    {
+        return length_t(m_chunks.size() << B);
+    }
+    /// Return (a reference to) the element at position 'index'; throws std::out_of_range if index >= size.
+    T &operator[](length_t index)
+    {
+        check_index(index);
+        return at_unchecked(index);
+    }
+    const T &operator[](length_t index) const
+    {
+        check_index(index);
+        return at_unchecked(index);
+    }
+    /// Return (a reference to) the element at position 'index' without checking the index; in
+    /// DEBUG builds, only whether its chunk is allocated is checked.
+    T &at_unchecked(length_t index)
+    {
+        return m_chunks.at_unchecked(index >> B)[index & (chunk_size - 1)];
+    }
+    const T &at_unchecked(length_t index) const
+    {
+        return m_chunks.at_unchecked(index >> B)[index & (chunk_size - 1)];
+    }
+    /// Return the first item.
+    T &first() { return (*this)[0]; }
+    const T &first() const { return (*this)[0]; }
+    /// Return the last item.
+    T &last() { return (*this)[m_size - 1]; }
+    const T &last() const { return (*this)[m_size - 1]; }
+    /// Return iterators to the beginning and the end of the items; adding items does not
+    /// invalidate them (they read the chunk directory through the array, which must not be moved
+    /// or swapped meanwhile).
+    iterator begin() { return iterator(&m_chunks, 0); }
+    iterator end() { return iterator(&m_chunks, m_size); }
+    const_iterator begin() const { return const_iterator(&m_chunks, 0); }
+    const_iterator end() const { return const_iterator(&m_chunks, m_size); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    /// Return the number of chunks holding items.
+    length_t chunk_count() const
+    {
+        return length_t((m_size >> B) + ((m_size & (chunk_size - 1)) != 0));
+    }
+    /// Return a view of the items of chunk k (k < chunk_count()), which are contiguous; the
+    /// first item of the view is item k * chunk_size of the array.
+    array_view<T, L> chunk(length_t k)
+    {
+        return array_view<T, L>(m_chunks[k], chunk_length(k));
+    }
+    array_view<const T, L> chunk(length_t k) const
+    {
+        return array_view<const T, L>(m_chunks[k], chunk_length(k));
+    }
+    /// Perform a linear search for a specific item (operator '==' must be defined for class T)
+    template <typename V, typename Pred>
+    length_t linearSearch(V value, Pred pred) const
+    {
+        for (length_t k = 0; k < chunk_count(); k++) {
+            length_t index = chunk(k).linearSearch(value, pred);
+            if (index < chunk_length(k)) {
+                return length_t((k << B) + index);
+            }
+        }
+        return m_size;
+    }
+    /// Perform a linear search for an item equal to 'value'; return its index, or size() if it is
+    /// not found. Vectorized for arithmetic types.
+    length_t linearSearch(const T &value) const
+    {
+        for (length_t k = 0; k < chunk_count(); k++) {
+            length_t index = chunk(k).linearSearch(value);
+            if (index < chunk_length(k)) {
+                return length_t((k << B) + index);
+            }
+        }
+        return m_size;
+    }
+    /// Perform a binary search on the items; see dynamic_array::binarySearch(). The chunk is found
+    /// by a binary search on the last items of the chunks, then the item within the chunk.
+    template <typename V, typename Pred>
+    length_t binarySearch(V value, Pred pred) const
+    {
+        return lower_bound(value, [&pred](const T &item, const V &v) { return pred(item, v) < 0; });
+    }
+    /// Perform a binary search on items sorted by operator<; same result as the above.
+    length_t binarySearch(const T &value) const
+    {
+        return lower_bound(value, [](const T &item, const T &v) { return item < v; });
+    }
+    /// Return the number of items equal to 'value'. Vectorized for arithmetic types.
+    length_t count(const T &value) const
+    {
+        length_t total = 0;
+        for (length_t k = 0; k < chunk_count(); k++) {
+            total += chunk(k).count(value);
+        }
+        return total;
+    }
+    /// Return the index of the first minimum item (by operator<), or size() if the array is empty.
+    length_t min_index() const
+    {
+        return extremum([](const T &candidate, const T &best) { return candidate < best; },
+                        [](array_view<const T, L> items) { return items.min_index(); });
+    }
+    /// Return the index of the first maximum item (by operator<), or size() if the array is empty.
+    length_t max_index() const
+    {
+        return extremum([](const T &candidate, const T &best) { return best < candidate; },
+                        [](array_view<const T, L> items) { return items.max_index(); });
+    }
+protected:
+    // Helper functions.
+    /// Check an index is within range
+    void check_index(length_t index) const
+    {
+        if (index >= m_size) {
+            throw std::out_of_range("index out of range");
+        }
+    }
+    /// Return the number of items in chunk k (k < chunk_count()).
+    length_t chunk_length(length_t k) const
+    {
+        return k + 1 < chunk_count() ? chunk_size : length_t(m_size - (k << B));
+    }
+    /// Allocate one more chunk, for an array whose chunks are all full.
+    void add_chunk()
+    {
+        // Grow the directory first, so that a failing allocation leaks no chunk.
+        if (m_chunks.size() == m_chunks.capacity()) {
+            m_chunks.reserve(dynamic_array<T*, L>::growth_policy::template next_capacity<T*>(
+                m_chunks.capacity(), length_t(m_chunks.size() + 1)));
+        }
+        m_chunks.push_back(alloc_traits::allocate(m_allocator, chunk_size));
+    }
+    /// Return the chunks from 'first' on to the allocator.
+    void release_chunks(length_t first)
+    {
+        while (m_chunks.size() > first) {
+            alloc_traits::deallocate(m_allocator, m_chunks.last(), chunk_size);
+            m_chunks.pop_back();
+        }
+    }
+    /// Return the index of the first item for which less(item, value) does not hold, or the last
+    /// index if there is none (0 for an empty array).
+    template <typename V, typename Less>
+    length_t lower_bound(const V &value, Less less) const
+    {
+        if (m_size == 0) {
+            return 0;
+        }
+        // All the chunks before the last one in use are full; pick the first of them whose last
+        // item is not ordered before the value, or else the last one.
+        length_t full = length_t(chunk_count() - 1);
+        length_t k = array_algorithms::lower_bound(m_chunks.data(), full, value,
+                                                   [&less](T *const &c, const V &v) { return less(c[chunk_size - 1], v); });
+        length_t index = length_t((k << B) + array_algorithms::lower_bound(m_chunks[k], chunk_length(k), value, less));
+        return index < m_size ? index : length_t(m_size - 1);
+    }
+    /// Return the index of the first item that no other item is better than, combining the
+    /// results of 'find' (the index of the best item of a view) on each chunk.
+    template <typename Better, typename Find>
+    length_t extremum(Better better, Find find) const
+    {
+        length_t best = m_size;
+        for (length_t k = 0; k < chunk_count(); k++) {
+            length_t index = length_t((k << B) + find(chunk(k)));
+            if (best == m_size || better(at_unchecked(index), at_unchecked(best))) {
+                best = index;
+            }
+        }
+        return best;
+    }
+private:
+    length_t m_size;
+    /// The chunks in use, followed by the chunks kept for reuse.
+    dynamic_array<T*, L> m_chunks;
+    allocator_type m_allocator;
+};
+
+template <typename T, typename L, unsigned int B, typename A>
+constexpr L segmented_array<T, L, B, A>::chunk_size;
@@ -0,0 +1,367 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * \brief SIMD kernels for searching arrays of arithmetic items, dispatched at runtime.
+ *
+ * On x86-64 with GCC or Clang, find() and count() use SSE2 (always available there) or AVX2 when
+ * the CPU supports it, and min_index()/max_index() use AVX2 when available. The AVX2 code is
+ * compiled with function-level target attributes, so no special compiler flags are needed and
+ * the binary still runs on CPUs without AVX2. has_kernels<T> tells whether kernels exist for an
+ * item type; array_algorithms falls back to plain loops otherwise (and on other platforms, where
+ * compilers auto-vectorize those loops as far as they can).
+ *
+ * Semantics match the scalar loops: equality is operator== (so 0.0 == -0.0 and NaN matches
+ * nothing), and min/max follow operator< scanning from the start, hence they return the first
+ * extreme item and skip NaNs unless the first item is one.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define CONTAINERS_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace simd {
+
+#ifdef CONTAINERS_SIMD_X86
+
+namespace detail {
+
+template <typename T>
+struct is_kernel_type
+    : std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value &&
+                                   (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)>
+{};
+
+/// Lane operations; masks have one bit per byte, i.e. sizeof(T) bits per lane.
+template <std::size_t Size, bool Signed, bool Float>
+struct sse2_ops;
+
+template <bool Signed>
+struct sse2_ops<1, Signed, false> {
+    using vec = __m128i;
+    static vec load(const void *p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+    static vec set1(std::int8_t v) { return _mm_set1_epi8(v); }
+    static unsigned eq_mask(vec a, vec b) { return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)); }
+};
+template <bool Signed>
+struct sse2_ops<2, Signed, false> {
+    using vec = __m128i;
+    static vec load(const void *p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+    static vec set1(std::int16_t v) { return _mm_set1_epi16(v); }
+    static unsigned eq_mask(vec a, vec b) { return _mm_movemask_epi8(_mm_cmpeq_epi16(a, b)); }
+};
+template <bool Signed>
+struct sse2_ops<4, Signed, false> {
+    using vec = __m128i;
+    static vec load(const void *p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+    static vec set1(std::int32_t v) { return _mm_set1_epi32(v); }
+    static unsigned eq_mask(vec a, vec b) { return _mm_movemask_epi8(_mm_cmpeq_epi32(a, b)); }
+};
+template <bool Signed>
+struct sse2_ops<8, Signed, false> {
+    using vec = __m128i;
+    static vec load(const void *p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+    static vec set1(std::int64_t v) { return _mm_set1_epi64x(v); }
+    static unsigned eq_mask(vec a, vec b)
+    {
+        // A 64-bit lane is equal if both of its 32-bit halves are.
+        __m128i c = _mm_cmpeq_epi32(a, b);
+        return _mm_movemask_epi8(_mm_and_si128(c, _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+};
+template <>
+struct sse2_ops<4, true, true> {
+    using vec = __m128;
+    static vec load(const void *p) { return _mm_loadu_ps(static_cast<const float*>(p)); }
+    static vec set1(float v) { return _mm_set1_ps(v); }
+    static unsigned eq_mask(vec a, vec b) { return _mm_movemask_epi8(_mm_castps_si128(_mm_cmpeq_ps(a, b))); }
+};
+template <>
+struct sse2_ops<8, true, true> {
+    using vec = __m128d;
+    static vec load(const void *p) { return _mm_loadu_pd(static_cast<const double*>(p)); }
+    static vec set1(double v) { return _mm_set1_pd(v); }
+    static unsigned eq_mask(vec a, vec b) { return _mm_movemask_epi8(_mm_castpd_si128(_mm_cmpeq_pd(a, b))); }
+};
+
+#define CONTAINERS_AVX2 __attribute__((target("avx2,popcnt")))
+
+template <std::size_t Size, bool Signed, bool Float>
+struct avx2_ops;
+
+/// Integer lane operations common to all sizes.
+struct avx2_int_ops {
+    using vec = __m256i;
+    static constexpr bool has_minmax = true;
+    CONTAINERS_AVX2 static vec load(const void *p) { return _mm256_loadu_si256(static_cast<const __m256i*>(p)); }
+    CONTAINERS_AVX2 static void store(void *p, vec v) { _mm256_storeu_si256(static_cast<__m256i*>(p), v); }
+};
+template <>
+struct avx2_ops<1, true, false> : avx2_int_ops {
+    CONTAINERS_AVX2 static vec set1(std::int8_t v) { return _mm256_set1_epi8(v); }
+    CONTAINERS_AVX2 static unsigned eq_mask(vec a, vec b) { return _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)); }
+    CONTAINERS_AVX2 static vec min(vec a, vec b) { return _mm256_min_epi8(a, b); }
+    CONTAINERS_AVX2 static vec max(vec a, vec b) { return _mm256_max_epi8(a, b); }
+};
+template <>
+struct avx2_ops<1, false, false> : avx2_ops<1, true, false> {
+    CONTAINERS_AVX2 static vec min(vec a, vec b) { return _mm256_min_epu8(a, b); }
+    CONTAINERS_AVX2 static vec max(vec a, vec b) { return _mm256_max_epu8(a, b); }
+};
+template <>
+struct avx2_ops<2, true, false> : avx2_int_ops {
+    CONTAINERS_AVX2 static vec set1(std::int16_t v) { return _mm256_set1_epi16(v); }
+    CONTAINERS_AVX2 static unsigned eq_mask(vec a, vec b) { return _mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b)); }
+    CONTAINERS_AVX2 static vec min(vec a, vec b) { return _mm256_min_epi16(a, b); }
+    CONTAINERS_AVX2 static vec max(vec a, vec b) { return _mm256_max_epi16(a, b); }
+};
+template <>
+struct avx2_ops<2, false, false> : avx2_ops<2, true, false> {
+    CONTAINERS_AVX2 static vec min(vec a, vec b) { return _mm256_min_epu16(a, b); }
+    CONTAINERS_AVX2 static vec max(vec a, vec b) { return _mm256_max_epu16(a, b); }
+};
+template <>
+struct avx2_ops<4, true, false> : avx2_int_ops {
+    CONTAINERS_AVX2 static vec set1(std::int32_t v) { return _mm256_set1_epi32(v); }
+    CONTAINERS_AVX2 static unsigned eq_mask(vec a, vec b) { return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)); }
+    CONTAINERS_AVX2 static vec min(vec a, vec b) { return _mm256_min_epi32(a, b); }
+    CONTAINERS_AVX2 static vec max(vec a, vec b) { return _mm256_max_epi32(a, b); }
+};
+template <>
+struct avx2_ops<4, false, false> : avx2_ops<4, true, false> {
+    CONTAINERS_AVX2 static vec min(vec a, vec b) { return _mm256_min_epu32(a, b); }
+    CONTAINERS_AVX2 static vec max(vec a, vec b) { return _mm256_max_epu32(a, b); }
+};
+/// AVX2 has no 64-bit integer min/max; those use the scalar loops.
+template <bool Signed>
+struct avx2_ops<8, Signed, false> : avx2_int_ops {
+    static constexpr bool has_minmax = false;
+    CONTAINERS_AVX2 static vec set1(std::int64_t v) { return _mm256_set1_epi64x(v); }
+    CONTAINERS_AVX2 static unsigned eq_mask(vec a, vec b) { return _mm256_movemask_epi8(_mm256_cmpeq_epi64(a, b)); }
+};
+/// For floating point lanes, min(x, acc) returns acc if x is NaN, which skips NaNs like operator<.
+template <>
+struct avx2_ops<4, true, true> {
+    using vec = __m256;
+    static constexpr bool has_minmax = true;
+    CONTAINERS_AVX2 static vec load(const void *p) { return _mm256_loadu_ps(static_cast<const float*>(p)); }
+    CONTAINERS_AVX2 static void store(void *p, vec v) { _mm256_storeu_ps(static_cast<float*>(p), v); }
+    CONTAINERS_AVX2 static vec set1(float v) { return _mm256_set1_ps(v); }
+    CONTAINERS_AVX2 static unsigned eq_mask(vec a, vec b)
+    { return _mm256_movemask_epi8(_mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_EQ_OQ))); }
+    CONTAINERS_AVX2 static vec min(vec x, vec acc) { return _mm256_min_ps(x, acc); }
+    CONTAINERS_AVX2 static vec max(vec x, vec acc) { return _mm256_max_ps(x, acc); }
+};
+template <>
+struct avx2_ops<8, true, true> {
+    using vec = __m256d;
+    static constexpr bool has_minmax = true;
+    CONTAINERS_AVX2 static vec load(const void *p) { return _mm256_loadu_pd(static_cast<const double*>(p)); }
+    CONTAINERS_AVX2 static void store(void *p, vec v) { _mm256_storeu_pd(static_cast<double*>(p), v); }
+    CONTAINERS_AVX2 static vec set1(double v) { return _mm256_set1_pd(v); }
+    CONTAINERS_AVX2 static unsigned eq_mask(vec a, vec b)
+    { return _mm256_movemask_epi8(_mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_EQ_OQ))); }
+    CONTAINERS_AVX2 static vec min(vec x, vec acc) { return _mm256_min_pd(x, acc); }
+    CONTAINERS_AVX2 static vec max(vec x, vec acc) { return _mm256_max_pd(x, acc); }
+};
+
+template <typename T>
+using sse2 = sse2_ops<sizeof(T), std::is_signed<T>::value, std::is_floating_point<T>::value>;
+template <typename T>
+using avx2 = avx2_ops<sizeof(T), std::is_signed<T>::value, std::is_floating_point<T>::value>;
+
+inline bool cpu_has_avx2()
+{
+#ifdef __AVX2__
+    return true;
+#else
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return supported;
+#endif
+}
+
+template <typename T>
+std::size_t find_sse2(const T *data, std::size_t size, T value)
+{
+    using ops = sse2<T>;
+    const std::size_t lanes = 16 / sizeof(T);
+    const typename ops::vec v = ops::set1(value);
+    std::size_t i = 0;
+    for (; i + 2 * lanes <= size; i += 2 * lanes) {
+        unsigned m = ops::eq_mask(ops::load(data + i), v) | ops::eq_mask(ops::load(data + i + lanes), v) << 16;
+        if (m) {
+            return i + __builtin_ctz(m) / sizeof(T);
+        }
+    }
+    for (; i < size; i++) {
+        if (data[i] == value) {
+            return i;
+        }
+    }
+    return size;
+}
+
+template <typename T>
+std::size_t count_sse2(const T *data, std::size_t size, T value)
+{
+    using ops = sse2<T>;
+    const std::size_t lanes = 16 / sizeof(T);
+    const typename ops::vec v = ops::set1(value);
+    std::size_t bits = 0, i = 0;
+    for (; i + lanes <= size; i += lanes) {
+        bits += __builtin_popcount(ops::eq_mask(ops::load(data + i), v));
+    }
+    std::size_t count = bits / sizeof(T);
+    for (; i < size; i++) {
+        count += data[i] == value;
+    }
+    return count;
+}
+
+template <typename T>
+CONTAINERS_AVX2 std::size_t find_avx2(const T *data, std::size_t size, T value)
+{
+    using ops = avx2<T>;
+    const std::size_t lanes = 32 / sizeof(T);
+    const typename ops::vec v = ops::set1(value);
+    std::size_t i = 0;
+    for (; i + 2 * lanes <= size; i += 2 * lanes) {
+        std::uint64_t m = ops::eq_mask(ops::load(data + i), v) |
+                          std::uint64_t(ops::eq_mask(ops::load(data + i + lanes), v)) << 32;
+        if (m) {
+            return i + __builtin_ctzll(m) / sizeof(T);
+        }
+    }
+    for (; i < size; i++) {
+        if (data[i] == value) {
+            return i;
+        }
+    }
+    return size;
+}
+
+template <typename T>
+CONTAINERS_AVX2 std::size_t count_avx2(const T *data, std::size_t size, T value)
+{
+    using ops = avx2<T>;
+    const std::size_t lanes = 32 / sizeof(T);
+    const typename ops::vec v = ops::set1(value);
+    std::size_t bits = 0, i = 0;
+    for (; i + lanes <= size; i += lanes) {
+        bits += __builtin_popcount(ops::eq_mask(ops::load(data + i), v));
+    }
+    std::size_t count = bits / sizeof(T);
+    for (; i < size; i++) {
+        count += data[i] == value;
+    }
+    return count;
+}
+
+/// Reduce the array to its minimum (Max = false) or maximum value, then find its first index.
+template <bool Max, typename T>
+CONTAINERS_AVX2 std::size_t extremum_avx2(const T *data, std::size_t size)
+{
+    using ops = avx2<T>;
+    const std::size_t lanes = 32 / sizeof(T);
+    if (size == 0 || !(data[0] == data[0])) {
+        return 0; // empty, or a leading NaN which operator< never replaces
+    }
+    typename ops::vec acc = ops::set1(data[0]);
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+        acc = Max ? ops::max(ops::load(data + i), acc) : ops::min(ops::load(data + i), acc);
+    }
+    T values[32 / sizeof(T)];
+    ops::store(values, acc);
+    T best = values[0];
+    for (std::size_t j = 1; j < lanes; j++) {
+        if (Max ? best < values[j] : values[j] < best) {
+            best = values[j];
+        }
+    }
+    for (; i < size; i++) {
+        if (Max ? best < data[i] : data[i] < best) {
+            best = data[i];
+        }
+    }
+    return find_avx2(data, size, best);
+}
+
+} // namespace detail
+
+/// Whether find() and count() kernels exist for items of type T.
+template <typename T>
+struct has_kernels : detail::is_kernel_type<T> {};
+
+/// Whether min_index() and max_index() kernels exist for items of type T (AVX2 only).
+template <typename T, bool = has_kernels<T>::value>
+struct has_minmax_kernels : std::integral_constant<bool, detail::avx2<T>::has_minmax> {};
+template <typename T>
+struct has_minmax_kernels<T, false> : std::false_type {};
+
+/// Return the index of the first item equal to 'value', or 'size' if there is none.
+template <typename T>
+std::size_t find(const T *data, std::size_t size, T value)
+{
+    return detail::cpu_has_avx2() ? detail::find_avx2(data, size, value)
+                                  : detail::find_sse2(data, size, value);
+}
+
+/// Return the number of items equal to 'value'.
+template <typename T>
+std::size_t count(const T *data, std::size_t size, T value)
+{
+    return detail::cpu_has_avx2() ? detail::count_avx2(data, size, value)
+                                  : detail::count_sse2(data, size, value);
+}
+
+/// Whether min_index()/max_index() can run on this CPU.
+inline bool minmax_available()
+{
+    return detail::cpu_has_avx2();
+}
+
+/// Return the index of the first minimum item, 0 if empty; requires minmax_available().
+template <typename T>
+std::size_t min_index(const T *data, std::size_t size)
+{
+    return detail::extremum_avx2<false>(data, size);
+}
+
+/// Return the index of the first maximum item, 0 if empty; requires minmax_available().
+template <typename T>
+std::size_t max_index(const T *data, std::size_t size)
+{
+    return detail::extremum_avx2<true>(data, size);
+}
+
+#undef CONTAINERS_AVX2
+
+#else
+
+template <typename T>
+struct has_kernels : std::false_type {};
+
+template <typename T>
+struct has_minmax_kernels : std::false_type {};
+
+inline bool minmax_available()
+{
+    return false;
+}
+
+// Never called: array_algorithms only dispatches here when has_kernels<T> holds.
+template <typename T>
+std::size_t find(const T *, std::size_t size, T) { return size; }
+template <typename T>
+std::size_t count(const T *, std::size_t, T) { return 0; }
+template <typename T>
+std::size_t min_index(const T *, std::size_t) { return 0; }
+template <typename T>
+std::size_t max_index(const T *, std::size_t) { return 0; }
+
+#endif
+
+} // namespace simd
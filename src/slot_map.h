@@ -0,0 +1,215 @@
+#pragma once
+#include <stdexcept>
+#include <utility>
+#include "array_view.h"
+#include "dynamic_array.h"
+
+/**
+ * \brief A container handing out stable, generation-checked handles to densely stored values.
+ *
+ * The values are stored contiguously in a dynamic_array, in no particular order, so iterating
+ * over them is as fast as over a plain array; erasing one moves the last value into its place
+ * (swap_remove), so the values never have holes. Handles stay valid across these moves through
+ * an indirection table of slots: a handle names a slot, and the slot holds the current position
+ * of its value. Insertion, erasure and lookup are O(1).
+ *
+ * Each slot carries a generation counter, odd while the slot holds a value and even while it is
+ * free, which is bumped on both insertion and erasure. A handle records the generation of its
+ * slot when it was handed out, so a handle to an erased value (even if the slot has been reused
+ * since) is detected as stale instead of silently naming another value. Counters wrap around
+ * after 2^(bits of L - 1) reuses of the same slot.
+ *
+ *     slot_map<particle> particles;
+ *     slot_map<particle>::handle h = particles.insert(p);
+ *     for (particle &q : particles) { ... }   // dense iteration
+ *     if (particle *q = particles.find(h)) { ... }
+ *     particles.erase(h);
+ */
+
+template <typename T, typename L = unsigned int>
+class slot_map {
+public:
+    using length_t = L;
+
+    /// A reference to a value that stays valid until the value is erased.
+    struct handle {
+        length_t index;
+        length_t generation;
+
+        bool operator==(const handle &other) const
+        {
+            return index == other.index && generation == other.generation;
+        }
+        bool operator!=(const handle &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    /// Default constructor.
+    slot_map()
+        : m_free(none)
+    {}
+    /// Make sure the map can hold 'capacity' values without growing.
+    void reserve(length_t capacity)
+    {
+        m_values.reserve(capacity);
+        m_owners.reserve(capacity);
+        m_slots.reserve(capacity);
+    }
+    /// Construct a value in-place; return its handle.
+    template <typename ...Args>
+    handle emplace(Args &&...args)
+    {
+        // Make room everywhere first, so that a failing allocation or constructor changes nothing.
+        length_t index = m_free;
+        if (index == none) {
+            reserve_one(m_slots);
+        }
+        reserve_one(m_owners);
+        m_values.emplace_back(std::forward<Args>(args)...);
+        if (index == none) {
+            index = m_slots.size();
+            m_slots.push_back(slot{0, 0});
+        }
+        else {
+            m_free = m_slots[index].position;
+        }
+        slot &s = m_slots[index];
+        s.position = m_values.size() - 1;
+        s.generation++;
+        m_owners.push_back(index);
+        return handle{index, s.generation};
+    }
+    /// Insert a value; return its handle.
+    handle insert(T value)
+    {
+        return emplace(std::move(value));
+    }
+    /// Erase the value of a handle; return false (erasing nothing) if the handle is stale.
+    bool erase(handle h)
+    {
+        if (!contains(h)) {
+            return false;
+        }
+        slot &s = m_slots[h.index];
+        length_t position = s.position;
+        // The last value moves into the hole; point its slot at its new position.
+        length_t last = m_values.size() - 1;
+        m_slots[m_owners[last]].position = position;
+        m_owners[position] = m_owners[last];
+        m_owners.pop_back();
+        m_values.swap_remove(position);
+        s.generation++;
+        s.position = m_free;
+        m_free = h.index;
+        return true;
+    }
+    /// Return whether a handle refers to a value of the map.
+    bool contains(handle h) const
+    {
+        return h.index < m_slots.size() && m_slots[h.index].generation == h.generation && (h.generation & 1);
+    }
+    /// Return a pointer to the value of a handle, or nullptr if the handle is stale.
+    T *find(handle h)
+    {
+        return contains(h) ? &m_values[m_slots[h.index].position] : nullptr;
+    }
+    const T *find(handle h) const
+    {
+        return contains(h) ? &m_values[m_slots[h.index].position] : nullptr;
+    }
+    /// Return (a reference to) the value of a handle; throws std::out_of_range if it is stale.
+    T &operator[](handle h)
+    {
+        return *checked(find(h));
+    }
+    const T &operator[](handle h) const
+    {
+        return *checked(find(h));
+    }
+    /// Return the handle of the value at (dense) position 'index'.
+    handle handle_at(length_t index) const
+    {
+        length_t owner = m_owners[index];
+        return handle{owner, m_slots[owner].generation};
+    }
+    /// Return the number of values.
+    length_t size() const
+    {
+        return m_values.size();
+    }
+    /// Return whether the map holds no values.
+    bool empty() const
+    {
+        return m_values.size() == 0;
+    }
+    /// Erase all the values; all handles become stale.
+    void clear()
+    {
+        for (length_t i = 0; i < m_owners.size(); i++) {
+            slot &s = m_slots[m_owners[i]];
+            s.generation++;
+            s.position = m_free;
+            m_free = m_owners[i];
+        }
+        m_owners.clear();
+        m_values.clear();
+    }
+    /// Return iterators over the values, in storage order (which changes on erasure).
+    T *begin() { return m_values.data(); }
+    T *end() { return m_values.data() + m_values.size(); }
+    const T *begin() const { return m_values.data(); }
+    const T *end() const { return m_values.data() + m_values.size(); }
+    /// Return a view of the values, in storage order.
+    array_view<T, L> values()
+    {
+        return m_values.view();
+    }
+    array_view<const T, L> values() const
+    {
+        return m_values.view();
+    }
+private:
+    /// A slot holds the position of its value while in use, and the next free slot otherwise.
+    struct slot {
+        length_t position;
+        length_t generation;
+    };
+    static const length_t none = length_t(-1);
+
+    /// Make room for one more item in an array.
+    template <typename Array>
+    static void reserve_one(Array &array)
+    {
+        if (array.size() == array.capacity()) {
+            using value_type = typename Array::value_type;
+            array.reserve(Array::growth_policy::template next_capacity<value_type>(array.capacity(),
+                                                                                    length_t(array.size() + 1)));
+        }
+    }
+    static T *checked(T *value)
+    {
+        if (!value) {
+            throw std::out_of_range("stale slot_map handle");
+        }
+        return value;
+    }
+    static const T *checked(const T *value)
+    {
+        if (!value) {
+            throw std::out_of_range("stale slot_map handle");
+        }
+        return value;
+    }
+
+    dynamic_array<T, L> m_values;
+    /// The slot of each value, by position.
+    dynamic_array<length_t, L> m_owners;
+    dynamic_array<slot, L> m_slots;
+    /// Head of the list of free slots.
+    length_t m_free;
+};
+
+template <typename T, typename L>
+const L slot_map<T, L>::none;
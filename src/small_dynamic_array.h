@@ -0,0 +1,459 @@
+#pragma once
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <stdexcept>
+#include "aligned_allocator.h"
+#include "array_algorithms.h"
+#include "array_view.h"
+
+/**
+ * \brief A dynamic array keeping its first N elements inline (small-buffer optimization).
+ *
+ * It offers the same interface as dynamic_array, so that the two can be switched by a type alias,
+ * but it reserves room for N objects inside the object itself. As long as the array holds at most
+ * N items no heap allocation takes place; once it overflows, the items are relocated into a heap
+ * buffer obtained from the allocator A, which grows by doubling like dynamic_array.
+ *
+ * Differences from dynamic_array:
+ *  - The capacity never drops below N, and constructing with a capacity of up to N does not
+ *    allocate.
+ *  - Moving an array whose items are stored inline moves the items one by one (a memcpy for
+ *    trivially relocatable types) instead of stealing a pointer, so it is O(size) rather than O(1)
+ *    and references to the items are not preserved.
+ *  - The allocator never propagates on assignment or swap: each array keeps its own allocator and
+ *    swap() is implemented with moves.
+ */
+
+template <typename T, unsigned int N, typename L = unsigned int, typename A = aligned_allocator<T>>
+class small_dynamic_array {
+    static_assert(N > 0, "the inline capacity must not be zero");
+    using alloc_traits = typename std::allocator_traits<A>::template rebind_traits<T>;
+public:
+    using length_t = L;
+    using allocator_type = typename alloc_traits::allocator_type;
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    /// Number of items stored inline.
+    static constexpr length_t inline_capacity = N;
+
+    /// Default constructor.
+    small_dynamic_array()
+        : small_dynamic_array(0)
+    {}
+    /// Construct an empty array using a specific allocator.
+    explicit small_dynamic_array(const allocator_type &alloc)
+        : small_dynamic_array(0, alloc)
+    {}
+    /// Construct with an initial capacity; allocates only if it exceeds N.
+    small_dynamic_array(length_t capacity, const allocator_type &alloc = allocator_type())
+        : m_capacity(N), m_size(0), m_storage(inline_storage()), m_allocator(alloc)
+    {
+        if (capacity > N) {
+            grow(capacity);
+        }
+    }
+    /// Construct with an initial amount of copies.
+    small_dynamic_array(length_t count, const T &val, const allocator_type &alloc = allocator_type())
+        : small_dynamic_array(count, alloc)
+    {
+        for (length_t i = 0; i < count; i++) {
+            push_back(val);
+        }
+    }
+    /// Copy-constructor; performs a copy of the array.
+    small_dynamic_array(const small_dynamic_array &other)
+        : small_dynamic_array(other.m_size,
+                              alloc_traits::select_on_container_copy_construction(other.m_allocator))
+    {
+        for (length_t i = 0; i < other.m_size; i++) {
+            push_back(other.m_storage[i]);
+        }
+    }
+    /// Move-constructor; steals a heap buffer, or relocates inline items into the inline buffer
+    /// (which holds them all), so it never allocates.
+    small_dynamic_array(small_dynamic_array &&other) noexcept(std::is_nothrow_move_constructible<T>::value)
+        : small_dynamic_array(other.m_allocator)
+    {
+        take(other);
+    }
+    /// Copy-assignment operator.
+    small_dynamic_array &operator=(const small_dynamic_array &other)
+    {
+        if (this != &other) {
+            clear();
+            if (other.m_size > m_capacity) {
+                grow(other.m_size);
+            }
+            for (length_t i = 0; i < other.m_size; i++) {
+                push_back(other.m_storage[i]);
+            }
+        }
+        return *this;
+    }
+    /// Move-assignment operator.
+    small_dynamic_array &operator=(small_dynamic_array &&other)
+    {
+        if (this != &other) {
+            free();
+            m_storage = inline_storage();
+            m_capacity = N;
+            m_size = 0;
+            steal(other);
+        }
+        return *this;
+    }
+    /// Destructor
+    ~small_dynamic_array()
+    { free(); }
+    /// Swap two arrays (by moving their contents).
+    friend void swap(small_dynamic_array &first, small_dynamic_array &second)
+    {
+        small_dynamic_array temp(std::move(first));
+        first = std::move(second);
+        second = std::move(temp);
+    }
+    /// Return a copy of the allocator used for the heap buffer.
+    allocator_type get_allocator() const
+    {
+        return m_allocator;
+    }
+    /// Add an element to the end.
+    ///
+    /// Pass by value to handle the case when we are copying from the same array and the
+    /// potential grow() operation might invalidate the element to push_back().
+    void push_back(T element)
+    {
+        // If size plus one exceeds capacity, grow the array by doubling capacity
+        if ((m_size + 1) > m_capacity) {
+            grow(2 * m_capacity);
+        }
+        new (m_storage + m_size++) T(std::move(element));
+    }
+    /// Construct an element in-place at the end.
+    /// Return reference to the element.
+    template <typename ...Args>
+    T &emplace_back(Args &&...args)
+    {
+        if ((m_size + 1) > m_capacity) {
+            return emplace_back_grow(std::forward<Args>(args)...);
+        }
+        new (m_storage + m_size) T(std::forward<Args>(args)...);
+        return m_storage[m_size++];
+    }
+    /// Delete the last element.
+    void pop_back()
+    {
+        m_storage[--m_size].~T();
+    }
+    /// Delete an element by shifting back all items next to it.
+    void shift_remove(length_t index)
+    {
+        check_index(index);
+        array_algorithms::shift_remove(m_storage, m_size, index);
+        m_size--;
+    }
+    /// Delete an element by moving the last one on top of it.
+    void swap_remove(length_t index)
+    {
+        check_index(index);
+        array_algorithms::swap_remove(m_storage, m_size, index);
+        m_size--;
+    }
+    /// Delete all the items for which pred(item) holds, keeping the order of the others, in a
+    /// single pass. Return the number of items deleted.
+    template <typename Pred>
+    length_t remove_if(Pred pred)
+    {
+        length_t size = m_size;
+        m_size = array_algorithms::remove_if(m_storage, m_size, pred);
+        return size - m_size;
+    }
+    /// Delete all the items for which pred(item) holds by moving items from the end into the
+    /// holes; faster than remove_if(), but changes the order of the objects. Return the number
+    /// of items deleted.
+    template <typename Pred>
+    length_t swap_remove_if(Pred pred)
+    {
+        length_t size = m_size;
+        m_size = array_algorithms::swap_remove_if(m_storage, m_size, pred);
+        return size - m_size;
+    }
+    /// Delete the items in the index range [first, last), shifting back the items next to them
+    /// once; throws std::out_of_range if the range does not lie within the array.
+    void erase(length_t first, length_t last)
+    {
+        if (first > last || last > m_size) {
+            throw std::out_of_range("index out of range");
+        }
+        m_size = array_algorithms::erase(m_storage, m_size, first, last);
+    }
+    /// Delete the items at 'count' indices sorted in ascending order, in a single pass; throws
+    /// std::out_of_range (deleting nothing) if an index is not within the array.
+    void erase_indices(const length_t *indices, length_t count)
+    {
+        if (count && indices[count - 1] >= m_size) {
+            throw std::out_of_range("index out of range");
+        }
+        m_size = array_algorithms::erase_indices(m_storage, m_size, indices, count);
+    }
+    /// Return the size of the array (number of items contained).
+    length_t size() const
+    {
+        return m_size;
+    }
+    /// Return the capacity of the array (number of items can contain).
+    length_t capacity() const
+    {
+        return m_capacity;
+    }
+    /// Return whether the items are stored inline (no heap buffer is in use).
+    bool is_inline() const
+    {
+        return m_storage == inline_storage();
+    }
+    /// Return (a reference to) the element at position 'index'; throws std::out_of_range if index >= size.
+    T& operator[](length_t index)
+    {
+        check_index(index);
+        return m_storage[index];
+    }
+    /// The const-version of the above; implemented so that we can work with const arrays.
+    const T& operator[](length_t index) const
+    {
+        check_index(index);
+        return m_storage[index];
+    }
+    /// Return (a reference to) the element at position 'index' without checking the index, e.g.
+    /// in inner loops that the compiler should vectorize; checked only in DEBUG builds.
+    T& at_unchecked(length_t index)
+    {
+#ifdef DEBUG
+        check_index(index);
+#endif
+        return m_storage[index];
+    }
+    const T& at_unchecked(length_t index) const
+    {
+#ifdef DEBUG
+        check_index(index);
+#endif
+        return m_storage[index];
+    }
+    /// Return the first item.
+    T& first() { return (*this)[0]; }
+    const T& first() const { return (*this)[0]; }
+    /// Return the last item.
+    T& last() { return (*this)[m_size - 1]; }
+    const T& last() const { return (*this)[m_size - 1]; }
+    /// Return raw (read-only) access to data
+    const T *data() const
+    {
+        return m_storage;
+    }
+    /// Return raw access to data
+    T *data()
+    {
+        return m_storage;
+    }
+    /// Return iterators (raw pointers) to the beginning and the end of the items, to use the array
+    /// with range-for loops and the standard algorithms; growing the array invalidates them.
+    iterator begin() { return m_storage; }
+    iterator end() { return m_storage + m_size; }
+    const_iterator begin() const { return m_storage; }
+    const_iterator end() const { return m_storage + m_size; }
+    const_iterator cbegin() const { return m_storage; }
+    const_iterator cend() const { return m_storage + m_size; }
+    /// Return the last valid index.
+    length_t last_index() const
+    {
+        check_index(m_size - 1);
+        return m_size - 1;
+    }
+    /// Clear the array by destroying all items; the heap buffer (if any) is kept.
+    void clear()
+    {
+        for (length_t i = 0; i < m_size; i++) {
+            m_storage[i].~T();
+        }
+        m_size = 0;
+    }
+    /// Return a view of all the items.
+    array_view<T, L> view()
+    {
+        return array_view<T, L>(data(), m_size);
+    }
+    array_view<const T, L> view() const
+    {
+        return array_view<const T, L>(data(), m_size);
+    }
+    /// Convert to a view of all the items, e.g. to pass the array to a function taking a view.
+    operator array_view<T, L>()
+    {
+        return view();
+    }
+    operator array_view<const T, L>() const
+    {
+        return view();
+    }
+    /// Perform a linear search for a specific item (operator '==' must be defined for class T)
+    template <typename V, typename Pred>
+    length_t linearSearch(V value, Pred pred) const
+    {
+        return view().linearSearch(value, pred);
+    }
+    /// Perform a linear search for an item equal to 'value'; return its index, or size() if it is
+    /// not found. Vectorized for arithmetic types.
+    length_t linearSearch(const T &value) const
+    {
+        return view().linearSearch(value);
+    }
+    /// Perform a binary search on the items; pred(item, value) returns a negative number if the
+    /// item is ordered before the value. Return the index of the first item not ordered before
+    /// the value, or the last index if there is none (0 for an empty array).
+    template <typename V, typename Pred>
+    length_t binarySearch(V value, Pred pred) const
+    {
+        return view().binarySearch(value, pred);
+    }
+    /// Perform a binary search on items sorted by operator<; same result as the above.
+    length_t binarySearch(const T &value) const
+    {
+        return view().binarySearch(value);
+    }
+    /// Return the number of items equal to 'value'. Vectorized for arithmetic types.
+    length_t count(const T &value) const
+    {
+        return view().count(value);
+    }
+    /// Return the index of the first minimum item (by operator<), or size() if the array is empty.
+    length_t min_index() const
+    {
+        return view().min_index();
+    }
+    /// Return the index of the first maximum item (by operator<), or size() if the array is empty.
+    length_t max_index() const
+    {
+        return view().max_index();
+    }
+protected:
+    // Helper functions.
+    /// Check an index is within range
+    void check_index(length_t index) const
+    {
+        if (index >= m_size) {
+            throw std::out_of_range("index out of range");
+        }
+    }
+    T *inline_storage()
+    {
+        return reinterpret_cast<T*>(&m_inline);
+    }
+    const T *inline_storage() const
+    {
+        return reinterpret_cast<const T*>(&m_inline);
+    }
+    /// Grow into a new heap buffer (assumes capacity >= m_capacity)
+    void grow(length_t capacity)
+    {
+        T *newStorage = alloc_traits::allocate(m_allocator, capacity);
+        try {
+            array_algorithms::relocate(newStorage, m_storage, m_size);
+        }
+        catch (...) {
+            alloc_traits::deallocate(m_allocator, newStorage, capacity);
+            throw;
+        }
+        deallocate();
+        m_storage = newStorage;
+        m_capacity = capacity;
+    }
+    /// emplace_back() into a full array: construct the element in a new heap buffer of twice the
+    /// capacity, then relocate the items there, so that the arguments may refer to items of the
+    /// array itself.
+    template <typename ...Args>
+    T &emplace_back_grow(Args &&...args)
+    {
+        length_t capacity = 2 * m_capacity;
+        T *newStorage = alloc_traits::allocate(m_allocator, capacity);
+        try {
+            new (newStorage + m_size) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            alloc_traits::deallocate(m_allocator, newStorage, capacity);
+            throw;
+        }
+        try {
+            array_algorithms::relocate(newStorage, m_storage, m_size);
+        }
+        catch (...) {
+            newStorage[m_size].~T();
+            alloc_traits::deallocate(m_allocator, newStorage, capacity);
+            throw;
+        }
+        deallocate();
+        m_storage = newStorage;
+        m_capacity = capacity;
+        return m_storage[m_size++];
+    }
+    /// Take over the items of another array, which is left empty (assumes this array is empty and
+    /// inline); a heap buffer is only taken over if both allocators are interchangeable.
+    void steal(small_dynamic_array &other)
+    {
+        if (!other.is_inline() && !(m_allocator == other.m_allocator)) {
+            if (other.m_size > m_capacity) {
+                grow(other.m_size);
+            }
+            array_algorithms::relocate(m_storage, other.m_storage, other.m_size);
+            m_size = other.m_size;
+            other.m_size = 0;
+        }
+        else {
+            take(other);
+        }
+    }
+    /// Take over the heap buffer of another array, or relocate its inline items into the inline
+    /// buffer, without allocating (assumes this array is empty and inline, and that both
+    /// allocators are interchangeable).
+    void take(small_dynamic_array &other)
+    {
+        if (other.is_inline()) {
+            array_algorithms::relocate(m_storage, other.m_storage, other.m_size);
+            m_size = other.m_size;
+            other.m_size = 0;
+        }
+        else {
+            m_storage = other.m_storage;
+            m_capacity = other.m_capacity;
+            m_size = other.m_size;
+            other.m_storage = other.inline_storage();
+            other.m_capacity = N;
+            other.m_size = 0;
+        }
+    }
+    /// Return the heap buffer (if any) to the allocator, without destroying any objects.
+    void deallocate()
+    {
+        if (!is_inline()) {
+            alloc_traits::deallocate(m_allocator, m_storage, m_capacity);
+        }
+    }
+    /// Destroy all items and free the heap buffer.
+    void free()
+    {
+        clear();
+        deallocate();
+    }
+private:
+    length_t m_capacity;
+    length_t m_size;
+    T *m_storage;
+    allocator_type m_allocator;
+    typename std::aligned_storage<N * sizeof(T), alignof(T)>::type m_inline;
+};
+
+template <typename T, unsigned int N, typename L, typename A>
+constexpr typename small_dynamic_array<T, N, L, A>::length_t small_dynamic_array<T, N, L, A>::inline_capacity;
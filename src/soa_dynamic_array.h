@@ -0,0 +1,201 @@
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include "dynamic_array.h"
+
+/**
+ * \brief A structure-of-arrays container: records whose fields are stored in separate columns.
+ *
+ * The record layout is given as a tuple of field types, e.g.
+ *
+ *     soa_dynamic_array<std::tuple<float, float, int>> particles;
+ *     particles.emplace_back(x, y, id);
+ *     float *xs = particles.data<0>();          // contiguous column, ready for vectorized loops
+ *     std::get<2>(particles[i]) = 7;            // row access through a tuple of references
+ *
+ * Internally it keeps one dynamic_array per field; all columns always have the same size and are
+ * grown together through reserve(), so a loop reading one field touches only that field's
+ * memory. Rows are accessed through proxy references (tuples of references to the fields).
+ */
+
+template <typename Fields, typename L = unsigned int>
+class soa_dynamic_array;
+
+template <typename ...Ts, typename L>
+class soa_dynamic_array<std::tuple<Ts...>, L> {
+    static_assert(sizeof...(Ts) > 0, "at least one field is required");
+public:
+    using length_t = L;
+    /// Type of the I-th field.
+    template <std::size_t I>
+    using field_t = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+    /// Type of the array holding the I-th field.
+    template <std::size_t I>
+    using column_t = dynamic_array<field_t<I>, L>;
+    /// Proxy references to a row.
+    using reference = std::tuple<Ts&...>;
+    using const_reference = std::tuple<const Ts&...>;
+
+    /// Number of fields (columns).
+    static constexpr std::size_t columns = sizeof...(Ts);
+
+    /// Default constructor.
+    soa_dynamic_array()
+    {}
+    /// Construct with an initial capacity for every column.
+    soa_dynamic_array(length_t capacity)
+    {
+        reserve(capacity);
+    }
+    /// Make sure every column can hold at least 'capacity' rows without growing.
+    void reserve(length_t capacity)
+    {
+        for_each_column([capacity](auto &column) { column.reserve(capacity); });
+    }
+    /// Add a row at the end, constructing each field from the corresponding argument.
+    template <typename ...Args>
+    void emplace_back(Args &&...args)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Ts), "one argument per field is required");
+        if (size() == capacity()) {
+            emplace_back_grow(std::index_sequence_for<Ts...>(), std::forward<Args>(args)...);
+            return;
+        }
+        emplace_fields(std::index_sequence_for<Ts...>(), std::forward<Args>(args)...);
+    }
+    /// Add a row at the end.
+    void push_back(const std::tuple<Ts...> &row)
+    {
+        push_row(row, std::index_sequence_for<Ts...>());
+    }
+    /// Delete the last row.
+    void pop_back()
+    {
+        for_each_column([](auto &column) { column.pop_back(); });
+    }
+    /// Delete a row by shifting back all rows next to it.
+    void shift_remove(length_t index)
+    {
+        for_each_column([index](auto &column) { column.shift_remove(index); });
+    }
+    /// Delete a row by moving the last one on top of it.
+    void swap_remove(length_t index)
+    {
+        for_each_column([index](auto &column) { column.swap_remove(index); });
+    }
+    /// Clear the array by destroying all rows.
+    void clear()
+    {
+        for_each_column([](auto &column) { column.clear(); });
+    }
+    /// Return the number of rows.
+    length_t size() const
+    {
+        return std::get<0>(m_columns).size();
+    }
+    /// Return the number of rows the columns can hold without growing.
+    length_t capacity() const
+    {
+        return std::get<0>(m_columns).capacity();
+    }
+    /// Return a proxy reference to the row at 'index'; throws std::out_of_range if index >= size.
+    reference operator[](length_t index)
+    {
+        return row(index, std::index_sequence_for<Ts...>());
+    }
+    const_reference operator[](length_t index) const
+    {
+        return row(index, std::index_sequence_for<Ts...>());
+    }
+    /// Return (a reference to) field I of the row at 'index'.
+    template <std::size_t I>
+    field_t<I> &get(length_t index)
+    {
+        return std::get<I>(m_columns)[index];
+    }
+    template <std::size_t I>
+    const field_t<I> &get(length_t index) const
+    {
+        return std::get<I>(m_columns)[index];
+    }
+    /// Return raw access to the contiguous column of field I.
+    template <std::size_t I>
+    field_t<I> *data()
+    {
+        return std::get<I>(m_columns).data();
+    }
+    template <std::size_t I>
+    const field_t<I> *data() const
+    {
+        return std::get<I>(m_columns).data();
+    }
+    /// Return (read-only) access to the array holding field I, e.g. to run its searches.
+    template <std::size_t I>
+    const column_t<I> &column() const
+    {
+        return std::get<I>(m_columns);
+    }
+private:
+    template <typename F>
+    void for_each_column(F f)
+    {
+        for_each_column(f, std::index_sequence_for<Ts...>());
+    }
+    template <typename F, std::size_t ...I>
+    void for_each_column(F f, std::index_sequence<I...>)
+    {
+        int expand[] = { (f(std::get<I>(m_columns)), 0)... };
+        (void)expand;
+    }
+    template <std::size_t ...I, typename ...Args>
+    void emplace_fields(std::index_sequence<I...>, Args &&...args)
+    {
+        // Storage has been reserved, so only a constructor may throw; if one does, remove the
+        // fields already added so that the columns keep the same size.
+        length_t count = size();
+        try {
+            int expand[] = { (std::get<I>(m_columns).emplace_back(std::forward<Args>(args)), 0)... };
+            (void)expand;
+        }
+        catch (...) {
+            for_each_column([count](auto &column) {
+                if (column.size() > count) {
+                    column.pop_back();
+                }
+            });
+            throw;
+        }
+    }
+    /// emplace_back() into full columns: construct the fields first, since the arguments may
+    /// refer to fields of the array's own rows, then grow all the columns at once (so that a
+    /// failing allocation leaves all of them unchanged) and move the fields in.
+    template <std::size_t ...I, typename ...Args>
+    void emplace_back_grow(std::index_sequence<I...>, Args &&...args)
+    {
+        std::tuple<Ts...> fields(std::forward<Args>(args)...);
+        using growth_policy = typename column_t<0>::growth_policy;
+        reserve(growth_policy::template next_capacity<field_t<0>>(capacity(), length_t(size() + 1)));
+        emplace_fields(std::index_sequence<I...>(), std::get<I>(std::move(fields))...);
+    }
+    template <std::size_t ...I>
+    void push_row(const std::tuple<Ts...> &row, std::index_sequence<I...>)
+    {
+        emplace_back(std::get<I>(row)...);
+    }
+    template <std::size_t ...I>
+    reference row(length_t index, std::index_sequence<I...>)
+    {
+        return reference(std::get<I>(m_columns)[index]...);
+    }
+    template <std::size_t ...I>
+    const_reference row(length_t index, std::index_sequence<I...>) const
+    {
+        return const_reference(std::get<I>(m_columns)[index]...);
+    }
+
+    std::tuple<dynamic_array<Ts, L>...> m_columns;
+};
+
+template <typename ...Ts, typename L>
+constexpr std::size_t soa_dynamic_array<std::tuple<Ts...>, L>::columns;
@@ -0,0 +1,431 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "array_algorithms.h"
+#include "array_view.h"
+
+/**
+ * \brief The smallest unsigned integer type that can hold the value N, e.g. std::uint8_t for
+ * N < 256; the default length type of static_array.
+ */
+template <unsigned long long N>
+using smallest_length_t = typename std::conditional<N <= 0xff, std::uint8_t,
+                          typename std::conditional<N <= 0xffff, std::uint16_t,
+                          typename std::conditional<N <= 0xffffffff, std::uint32_t,
+                                                    std::uint64_t>::type>::type>::type;
+
+/**
+ * \brief Overflow policies of static_array, deciding what adding an item to a full array does.
+ *
+ * A policy has two compile-time flags and a hook:
+ *  - 'checked': whether the array checks for overflow at all; when false, the check is compiled
+ *    out and overflowing is undefined behaviour.
+ *  - 'drops': whether an item added to a full array is silently dropped (the hook returns).
+ *  - overflow(): called when an item is added to a full array; unless the policy drops items, it
+ *    does not return.
+ */
+
+/// Throw std::length_error (the default).
+struct overflow_throws {
+    static const bool checked = true;
+    static const bool drops = false;
+    [[noreturn]] static void overflow()
+    {
+        throw std::length_error("static_array is full");
+    }
+};
+
+/// Abort in DEBUG builds; in other builds nothing is checked, so adding an item costs no more than
+/// constructing it.
+struct overflow_asserts {
+#ifdef DEBUG
+    static const bool checked = true;
+#else
+    static const bool checked = false;
+#endif
+    static const bool drops = false;
+    [[noreturn]] static void overflow()
+    {
+        std::abort();
+    }
+};
+
+/// Drop the items that do not fit, e.g. for bounded logs or top-N buffers.
+struct overflow_drops {
+    static const bool checked = true;
+    static const bool drops = true;
+    static void overflow()
+    {}
+};
+
+/**
+ * \brief An array of at most N objects stored inline, with the interface of dynamic_array.
+ *
+ * The storage is part of the object, so the array never allocates, the capacity is a
+ * compile-time constant, and the length type defaults to the smallest unsigned integer able to
+ * hold N (e.g. a static_array<float, 16> takes 68 bytes: a one-byte size, padding and the
+ * items). Code templated over the array type can use either a dynamic_array or a static_array:
+ * the members adding, removing and accessing items, the views and the searches are the same.
+ *
+ * What happens when an item is added to a full array depends on the overflow policy O:
+ * overflow_throws (std::length_error), overflow_asserts (checked in DEBUG builds only) or
+ * overflow_drops. emplace_back() returns a reference to the new item, so it is not available
+ * with overflow_drops; try_emplace_back() works with every policy.
+ *
+ * As with small_dynamic_array, moving an array moves the items one by one (a memcpy for trivially
+ * relocatable types), and references to the items are not preserved.
+ */
+
+template <typename T, unsigned int N, typename L = smallest_length_t<N>, typename O = overflow_throws>
+class static_array {
+    static_assert(N > 0, "the capacity must not be zero");
+    static_assert(N <= static_cast<unsigned long long>(L(-1)), "the length type cannot hold the capacity");
+public:
+    using length_t = L;
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using overflow_policy = O;
+
+    /// Default constructor.
+    static_array()
+        : m_size(0)
+    {}
+    /// Construct with an initial amount of copies.
+    static_array(length_t count, const T &val)
+        : m_size(0)
+    {
+        for (length_t i = 0; i < count; i++) {
+            push_back(val);
+        }
+    }
+    /// Copy-constructor; performs a copy of the array.
+    static_array(const static_array &other)
+        : m_size(0)
+    {
+        array_algorithms::uninitialized_copy(storage(), other.storage(), other.m_size);
+        m_size = other.m_size;
+    }
+    /// Move-constructor; moves the items of another array, which is left empty.
+    static_array(static_array &&other) noexcept(std::is_nothrow_move_constructible<T>::value)
+        : m_size(0)
+    {
+        array_algorithms::relocate(storage(), other.storage(), other.m_size);
+        m_size = other.m_size;
+        other.m_size = 0;
+    }
+    /// Copy-assignment operator.
+    static_array &operator=(const static_array &other)
+    {
+        if (this != &other) {
+            clear();
+            array_algorithms::uninitialized_copy(storage(), other.storage(), other.m_size);
+            m_size = other.m_size;
+        }
+        return *this;
+    }
+    /// Move-assignment operator.
+    static_array &operator=(static_array &&other)
+    {
+        if (this != &other) {
+            clear();
+            array_algorithms::relocate(storage(), other.storage(), other.m_size);
+            m_size = other.m_size;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+    /// Destructor
+    ~static_array()
+    { clear(); }
+    /// Swap two arrays (by moving their contents).
+    friend void swap(static_array &first, static_array &second)
+    {
+        static_array temp(std::move(first));
+        first = std::move(second);
+        second = std::move(temp);
+    }
+    /// Add an element to the end; see the class documentation for a full array.
+    ///
+    /// Pass by value, like dynamic_array::push_back().
+    void push_back(T element)
+    {
+        if (overflow_policy::checked && m_size == N) {
+            overflow_policy::overflow();
+            return;
+        }
+        new (storage() + m_size) T(std::move(element));
+        m_size++;
+    }
+    /// Construct an element in-place at the end.
+    /// Return reference to the element.
+    template <typename ...Args>
+    T &emplace_back(Args &&...args)
+    {
+        static_assert(!overflow_policy::drops, "emplace_back() cannot drop items; use try_emplace_back()");
+        if (overflow_policy::checked && m_size == N) {
+            overflow_policy::overflow();
+        }
+        T *item = new (storage() + m_size) T(std::forward<Args>(args)...);
+        m_size++;
+        return *item;
+    }
+    /// Construct an element in-place at the end if the array is not full. Return a pointer to the
+    /// element, or nullptr if the array is full (whatever the overflow policy).
+    template <typename ...Args>
+    T *try_emplace_back(Args &&...args)
+    {
+        if (m_size == N) {
+            return nullptr;
+        }
+        T *item = new (storage() + m_size) T(std::forward<Args>(args)...);
+        m_size++;
+        return item;
+    }
+    /// Append copies of 'count' items starting at 'items', with a single capacity check and a
+    /// single memcpy for trivially copyable types. With overflow_drops, the items that do not fit
+    /// are dropped. The items must not belong to the array itself.
+    void append(const T *items, length_t count)
+    {
+        if (overflow_policy::checked && count > N - m_size) {
+            overflow_policy::overflow();
+            count = length_t(N - m_size);
+        }
+        array_algorithms::uninitialized_copy(storage() + m_size, items, count);
+        m_size += count;
+    }
+    /// Delete the last element.
+    void pop_back()
+    {
+        storage()[--m_size].~T();
+    }
+    /// Delete an element by shifting back all items next to it.
+    void shift_remove(length_t index)
+    {
+        check_index(index);
+        array_algorithms::shift_remove(storage(), m_size, index);
+        m_size--;
+    }
+    /// Delete an element by moving the last one on top of it.
+    void swap_remove(length_t index)
+    {
+        check_index(index);
+        array_algorithms::swap_remove(storage(), m_size, index);
+        m_size--;
+    }
+    /// Delete all the items for which pred(item) holds, keeping the order of the others, in a
+    /// single pass. Return the number of items deleted.
+    template <typename Pred>
+    length_t remove_if(Pred pred)
+    {
+        length_t size = m_size;
+        m_size = array_algorithms::remove_if(storage(), m_size, pred);
+        return length_t(size - m_size);
+    }
+    /// Delete all the items for which pred(item) holds by moving items from the end into the
+    /// holes; faster than remove_if(), but changes the order of the objects. Return the number
+    /// of items deleted.
+    template <typename Pred>
+    length_t swap_remove_if(Pred pred)
+    {
+        length_t size = m_size;
+        m_size = array_algorithms::swap_remove_if(storage(), m_size, pred);
+        return length_t(size - m_size);
+    }
+    /// Delete the items in the index range [first, last), shifting back the items next to them
+    /// once; throws std::out_of_range if the range does not lie within the array.
+    void erase(length_t first, length_t last)
+    {
+        if (first > last || last > m_size) {
+            throw std::out_of_range("index out of range");
+        }
+        m_size = array_algorithms::erase(storage(), m_size, first, last);
+    }
+    /// Delete the items at 'count' indices sorted in ascending order, in a single pass; throws
+    /// std::out_of_range (deleting nothing) if an index is not within the array.
+    void erase_indices(const length_t *indices, length_t count)
+    {
+        if (count && indices[count - 1] >= m_size) {
+            throw std::out_of_range("index out of range");
+        }
+        m_size = array_algorithms::erase_indices(storage(), m_size, indices, count);
+    }
+    /// Return the size of the array (number of items contained).
+    length_t size() const
+    {
+        return m_size;
+    }
+    /// Return the capacity of the array, N.
+    static constexpr length_t capacity()
+    {
+        return length_t(N);
+    }
+    /// Return whether the array holds no items.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+    /// Return whether the array holds N items.
+    bool full() const
+    {
+        return m_size == N;
+    }
+    /// Return (a reference to) the element at position 'index'; throws std::out_of_range if index >= size.
+    T& operator[](length_t index)
+    {
+        check_index(index);
+        return storage()[index];
+    }
+    /// The const-version of the above; implemented so that we can work with const arrays.
+    const T& operator[](length_t index) const
+    {
+        check_index(index);
+        return storage()[index];
+    }
+    /// Return (a reference to) the element at position 'index' without checking the index, e.g.
+    /// in inner loops that the compiler should vectorize; checked only in DEBUG builds.
+    T& at_unchecked(length_t index)
+    {
+#ifdef DEBUG
+        check_index(index);
+#endif
+        return storage()[index];
+    }
+    const T& at_unchecked(length_t index) const
+    {
+#ifdef DEBUG
+        check_index(index);
+#endif
+        return storage()[index];
+    }
+    /// Return the first item.
+    T& first() { return (*this)[0]; }
+    const T& first() const { return (*this)[0]; }
+    /// Return the last item.
+    T& last() { return (*this)[length_t(m_size - 1)]; }
+    const T& last() const { return (*this)[length_t(m_size - 1)]; }
+    /// Return raw (read-only) access to data
+    const T *data() const
+    {
+        return storage();
+    }
+    /// Return raw access to data
+    T *data()
+    {
+        return storage();
+    }
+    /// Return iterators (raw pointers) to the beginning and the end of the items, to use the array
+    /// with range-for loops and the standard algorithms.
+    iterator begin() { return storage(); }
+    iterator end() { return storage() + m_size; }
+    const_iterator begin() const { return storage(); }
+    const_iterator end() const { return storage() + m_size; }
+    const_iterator cbegin() const { return storage(); }
+    const_iterator cend() const { return storage() + m_size; }
+    /// Return the last valid index.
+    length_t last_index() const
+    {
+        check_index(length_t(m_size - 1));
+        return length_t(m_size - 1);
+    }
+    /// Clear the array by destroying all items.
+    void clear()
+    {
+        for (length_t i = 0; i < m_size; i++) {
+            storage()[i].~T();
+        }
+        m_size = 0;
+    }
+    /// Return a view of all the items.
+    array_view<T, L> view()
+    {
+        return array_view<T, L>(data(), m_size);
+    }
+    array_view<const T, L> view() const
+    {
+        return array_view<const T, L>(data(), m_size);
+    }
+    /// Convert to a view of all the items, e.g. to pass the array to a function taking a view.
+    operator array_view<T, L>()
+    {
+        return view();
+    }
+    operator array_view<const T, L>() const
+    {
+        return view();
+    }
+    /// Sort the items by operator<, with a radix sort for integers and floats.
+    void sort()
+    {
+        array_algorithms::sort(storage(), m_size);
+    }
+    /// Sort the items by comp(a, b) (true if a is ordered before b), with std::sort.
+    template <typename Compare>
+    void sort(Compare comp)
+    {
+        std::sort(begin(), end(), comp);
+    }
+    /// Perform a linear search for a specific item (operator '==' must be defined for class T)
+    template <typename V, typename Pred>
+    length_t linearSearch(V value, Pred pred) const
+    {
+        return view().linearSearch(value, pred);
+    }
+    /// Perform a linear search for an item equal to 'value'; return its index, or size() if it is
+    /// not found. Vectorized for arithmetic types.
+    length_t linearSearch(const T &value) const
+    {
+        return view().linearSearch(value);
+    }
+    /// Perform a binary search on the items; see dynamic_array::binarySearch().
+    template <typename V, typename Pred>
+    length_t binarySearch(V value, Pred pred) const
+    {
+        return view().binarySearch(value, pred);
+    }
+    /// Perform a binary search on items sorted by operator<; same result as the above.
+    length_t binarySearch(const T &value) const
+    {
+        return view().binarySearch(value);
+    }
+    /// Return the number of items equal to 'value'. Vectorized for arithmetic types.
+    length_t count(const T &value) const
+    {
+        return view().count(value);
+    }
+    /// Return the index of the first minimum item (by operator<), or size() if the array is empty.
+    length_t min_index() const
+    {
+        return view().min_index();
+    }
+    /// Return the index of the first maximum item (by operator<), or size() if the array is empty.
+    length_t max_index() const
+    {
+        return view().max_index();
+    }
+protected:
+    // Helper functions.
+    /// Check an index is within range
+    void check_index(length_t index) const
+    {
+        if (index >= m_size) {
+            throw std::out_of_range("index out of range");
+        }
+    }
+    T *storage()
+    {
+        return reinterpret_cast<T*>(&m_storage);
+    }
+    const T *storage() const
+    {
+        return reinterpret_cast<const T*>(&m_storage);
+    }
+private:
+    length_t m_size;
+    typename std::aligned_storage<N * sizeof(T), alignof(T)>::type m_storage;
+};
@@ -0,0 +1,101 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include "dynamic_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// An allocator resizing blocks with realloc, counting the calls; it can be told to fail so that
+/// the arrays fall back to relocating the items into a new block.
+template <typename T>
+class ResizingAllocator {
+public:
+    using value_type = T;
+
+    ResizingAllocator(int *reallocs, bool fail) : m_reallocs(reallocs), m_fail(fail) {}
+    template <typename U>
+    ResizingAllocator(const ResizingAllocator<U> &other) : m_reallocs(other.m_reallocs), m_fail(other.m_fail) {}
+    T *allocate(std::size_t n) { return static_cast<T*>(std::malloc(n * sizeof(T))); }
+    void deallocate(T *ptr, std::size_t) { std::free(ptr); }
+    T *reallocate(T *ptr, std::size_t, std::size_t new_n)
+    {
+        (*m_reallocs)++;
+        return m_fail ? nullptr : static_cast<T*>(std::realloc(ptr, new_n * sizeof(T)));
+    }
+    template <typename U>
+    bool operator==(const ResizingAllocator<U> &other) const { return m_reallocs == other.m_reallocs; }
+    template <typename U>
+    bool operator!=(const ResizingAllocator<U> &other) const { return m_reallocs != other.m_reallocs; }
+
+    int *m_reallocs;
+    bool m_fail;
+};
+
+template <std::size_t Align>
+bool check_reallocate()
+{
+    aligned_allocator<std::uint32_t, Align> alloc;
+    bool ok = true;
+    std::uint32_t *block = alloc.allocate(10);
+    for (std::uint32_t i = 0; i < 10; i++) {
+        block[i] = i;
+    }
+    for (std::size_t old_n = 10, n = 20; n < 200000 && ok; old_n = n, n = n * 3 + 1) {
+        block = alloc.reallocate(block, old_n, n);
+        ok = block && reinterpret_cast<std::uintptr_t>(block) % Align == 0;
+        for (std::uint32_t i = 0; i < 10 && ok; i++) {
+            ok = block[i] == i;
+        }
+    }
+    alloc.deallocate(block, 0);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    static_assert(allocator_has_reallocate<aligned_allocator<int>>::value, "aligned_allocator resizes blocks");
+    static_assert(!allocator_has_reallocate<std::allocator<int>>::value, "std::allocator does not");
+
+    check(check_reallocate<4>(), "Reallocation keeps the items");
+    check(check_reallocate<64>(), "Reallocation keeps the items and the alignment");
+    check(check_reallocate<4096>(), "Reallocation keeps the items and a page alignment");
+
+    aligned_dynamic_array<double, 64> doubles;
+    for (int i = 0; i < 100000; i++) {
+        doubles.push_back(i);
+    }
+    check(doubles[99999] == 99999 && doubles[12345] == 12345 &&
+          reinterpret_cast<std::uintptr_t>(doubles.data()) % 64 == 0,
+          "Arrays grow through reallocation");
+
+    int reallocs = 0, failed = 0;
+    dynamic_array<int, unsigned int, ResizingAllocator<int>> resized(ResizingAllocator<int>(&reallocs, false));
+    dynamic_array<int, unsigned int, ResizingAllocator<int>> relocated(ResizingAllocator<int>(&failed, true));
+    for (int i = 0; i < 1000; i++) {
+        resized.push_back(i);
+        relocated.push_back(i);
+    }
+    // Capacities 1, 2, ..., 1024: the first block is allocated, the next ten are resized.
+    check(reallocs == 10 && resized[999] == 999, "Growth tries the allocator's reallocate() first");
+    check(failed == 10 && relocated[999] == 999 && relocated[0] == 0,
+          "Growth falls back to relocating when reallocate() fails");
+
+    dynamic_array<std::string, unsigned int, ResizingAllocator<std::string>> strings(
+        ResizingAllocator<std::string>(&failed, false));
+    int before = failed;
+    for (int i = 0; i < 100; i++) {
+        strings.push_back(std::to_string(i));
+    }
+    check(failed == before && strings[99] == "99", "Items with non-trivial moves are never reallocated");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "dynamic_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// Reference implementations, mirroring the scalar loops.
+template <typename T>
+std::size_t ref_find(const std::vector<T> &v, T value)
+{
+    std::size_t i = 0;
+    while (i < v.size() && !(v[i] == value)) { i++; }
+    return i;
+}
+
+template <typename T>
+std::size_t ref_count(const std::vector<T> &v, T value)
+{
+    std::size_t n = 0;
+    for (const T &x : v) { n += x == value; }
+    return n;
+}
+
+template <bool Max, typename T>
+std::size_t ref_extremum(const std::vector<T> &v)
+{
+    if (v.empty()) {
+        return 0;
+    }
+    std::size_t best = 0;
+    for (std::size_t i = 1; i < v.size(); i++) {
+        if (Max ? v[best] < v[i] : v[i] < v[best]) { best = i; }
+    }
+    return best;
+}
+
+/// Compare the kernels (every available instruction set) with the reference loops on random
+/// arrays of all sizes up to 100 items, with values drawn from a small range so there are ties.
+template <typename T>
+void check_kernels(const char *name)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> values(0, 20);
+    bool ok = true;
+    for (std::size_t size = 0; size <= 100 && ok; size++) {
+        std::vector<T> v(size);
+        for (T &x : v) { x = T(values(rng)); }
+        if (std::is_floating_point<T>::value && size > 10) {
+            v[size / 2] = std::numeric_limits<T>::quiet_NaN();
+        }
+        for (int value = -1; value <= 21; value++) {
+            T t = T(value);
+            ok = ok && array_algorithms::find(v.data(), v.size(), t) == ref_find(v, t);
+            ok = ok && array_algorithms::count(v.data(), v.size(), t) == ref_count(v, t);
+#ifdef CONTAINERS_SIMD_X86
+            ok = ok && simd::detail::find_sse2(v.data(), v.size(), t) == ref_find(v, t);
+            ok = ok && simd::detail::count_sse2(v.data(), v.size(), t) == ref_count(v, t);
+#endif
+        }
+        if (size) {
+            ok = ok && array_algorithms::min_index(v.data(), v.size()) == ref_extremum<false>(v);
+            ok = ok && array_algorithms::max_index(v.data(), v.size()) == ref_extremum<true>(v);
+        }
+    }
+    check(ok, name);
+}
+
+template <typename T>
+T make_item(int i) { return T(i); }
+template <>
+std::string make_item<std::string>(int i) { return std::string(20, 'x') + std::to_string(i); }
+
+/// Compare the batch erasures with the equivalent std::vector operations on random arrays, for a
+/// trivially relocatable type and for a type with non-trivial moves.
+template <typename T>
+void check_erase(const char *name)
+{
+    std::mt19937 rng(11);
+    bool ok = true;
+    for (unsigned int size = 0; size <= 60 && ok; size++) {
+        std::vector<T> expected;
+        dynamic_array<T> a, b, c, d;
+        for (unsigned int i = 0; i < size; i++) {
+            expected.push_back(make_item<T>(int(rng() % 10)));
+            a.push_back(expected.back());
+        }
+        b = a;
+        c = a;
+        d = a;
+        T odd = make_item<T>(3);
+        auto pred = [&odd](const T &x) { return x < odd; };
+
+        std::vector<T> kept = expected;
+        kept.erase(std::remove_if(kept.begin(), kept.end(), pred), kept.end());
+        ok = ok && a.remove_if(pred) == size - kept.size() && a.size() == kept.size() &&
+             std::equal(kept.begin(), kept.end(), a.data());
+
+        unsigned int removed = b.swap_remove_if(pred);
+        std::vector<T> unordered(b.data(), b.data() + b.size()), sorted_kept = kept;
+        std::sort(unordered.begin(), unordered.end());
+        std::sort(sorted_kept.begin(), sorted_kept.end());
+        ok = ok && removed == size - kept.size() && unordered == sorted_kept;
+
+        unsigned int first = size ? rng() % size : 0, last = first + (size ? rng() % (size - first + 1) : 0);
+        std::vector<T> tail = expected;
+        tail.erase(tail.begin() + first, tail.begin() + last);
+        c.erase(first, last);
+        ok = ok && c.size() == tail.size() && std::equal(tail.begin(), tail.end(), c.data());
+
+        std::vector<unsigned int> indices;
+        std::vector<T> rest;
+        for (unsigned int i = 0; i < size; i++) {
+            if (rng() % 3 == 0) {
+                indices.push_back(i);
+                if (rng() % 4 == 0) {
+                    indices.push_back(i);
+                }
+            }
+            else {
+                rest.push_back(expected[i]);
+            }
+        }
+        d.erase_indices(indices.data(), (unsigned int)indices.size());
+        ok = ok && d.size() == rest.size() && std::equal(rest.begin(), rest.end(), d.data());
+    }
+    check(ok, name);
+}
+
+/// Return a random key, from a small range (many ties) or a wide one (all the radix passes).
+template <typename T>
+T random_key(std::mt19937_64 &rng, bool wide)
+{
+    long long v = wide ? (long long)(rng() >> 1) : (long long)(rng() % 50);
+    return T(std::is_signed<T>::value ? v - (wide ? (long long)(~0ull >> 2) : 25) : v);
+}
+
+template <>
+std::string random_key<std::string>(std::mt19937_64 &rng, bool wide)
+{
+    return std::to_string(wide ? rng() : rng() % 50);
+}
+
+/// Compare the sorts and the sorted insertions and merges with std::sort on random arrays.
+template <typename T>
+void check_sort(const char *name)
+{
+    std::mt19937_64 rng(13);
+    bool ok = true;
+    for (unsigned int size : {0u, 1u, 7u, 255u, 256u, 1000u, 20000u}) {
+        for (int wide = 0; wide < 2 && ok; wide++) {
+            std::vector<T> expected(size);
+            for (T &x : expected) {
+                x = random_key<T>(rng, wide != 0);
+            }
+            dynamic_array<T> a, b, merged, inserted;
+            a.append(expected.data(), (unsigned int)size);
+            b = a;
+            std::sort(expected.begin(), expected.end());
+            a.sort();
+            b.sort(3);
+            ok = ok && std::equal(expected.begin(), expected.end(), a.data()) &&
+                 std::equal(expected.begin(), expected.end(), b.data());
+
+            // Merge the first half of the sorted items into the sorted second half.
+            std::vector<T> half1(expected.begin(), expected.begin() + size / 2);
+            std::vector<T> half2(expected.begin() + size / 2, expected.end());
+            std::shuffle(half1.begin(), half1.end(), rng);
+            std::shuffle(half2.begin(), half2.end(), rng);
+            std::sort(half1.begin(), half1.end());
+            std::sort(half2.begin(), half2.end());
+            merged.append(half2.data(), (unsigned int)half2.size());
+            dynamic_array<T> batch;
+            batch.append(half1.data(), (unsigned int)half1.size());
+            merged.merge_sorted(batch);
+            ok = ok && merged.size() == size && std::equal(expected.begin(), expected.end(), merged.data());
+
+            if (size <= 1000) {
+                for (unsigned int i = 0; i < size; i++) {
+                    inserted.insert_sorted(a[(i * 7919) % size]);
+                }
+                ok = ok && std::equal(expected.begin(), expected.end(), inserted.data());
+            }
+        }
+    }
+    check(ok, name);
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef CONTAINERS_SIMD_X86
+    printf("AVX2 kernels: %s\n", simd::detail::cpu_has_avx2() ? "yes" : "no");
+#endif
+    check_kernels<std::int8_t>("Kernels on int8_t");
+    check_kernels<std::uint8_t>("Kernels on uint8_t");
+    check_kernels<std::int16_t>("Kernels on int16_t");
+    check_kernels<std::uint16_t>("Kernels on uint16_t");
+    check_kernels<std::int32_t>("Kernels on int32_t");
+    check_kernels<std::uint32_t>("Kernels on uint32_t");
+    check_kernels<std::int64_t>("Kernels on int64_t");
+    check_kernels<std::uint64_t>("Kernels on uint64_t");
+    check_kernels<float>("Kernels on float");
+    check_kernels<double>("Kernels on double");
+
+    std::vector<double> nans(50, 1.0);
+    nans[0] = std::numeric_limits<double>::quiet_NaN();
+    nans[30] = -1.0;
+    check(array_algorithms::min_index(nans.data(), nans.size()) == 0 &&
+          array_algorithms::find(nans.data(), nans.size(), nans[0]) == nans.size(),
+          "A leading NaN is the minimum and never found");
+
+    std::mt19937 rng(7);
+    bool ok = true;
+    for (unsigned int size = 0; size <= 200 && ok; size++) {
+        dynamic_array<int> sorted;
+        for (unsigned int i = 0; i < size; i++) {
+            sorted.push_back(int(rng() % 100));
+        }
+        std::sort(sorted.data(), sorted.data() + sorted.size());
+        for (int value = -1; value <= 101; value++) {
+            unsigned int expected = unsigned(std::lower_bound(sorted.data(), sorted.data() + size, value) - sorted.data());
+            if (expected == size && size) {
+                expected = size - 1;
+            }
+            ok = ok && sorted.binarySearch(value) == expected;
+            ok = ok && sorted.binarySearch(value, [](int a, int b) { return a - b; }) == expected;
+        }
+    }
+    check(ok, "Branchless binary search matches std::lower_bound");
+
+    dynamic_array<int> empty;
+    check(empty.binarySearch(3) == 0 && empty.linearSearch(3) == 0 && empty.min_index() == 0,
+          "Searching an empty array");
+
+    dynamic_array<std::string> words;
+    words.push_back("delta");
+    words.push_back("alpha");
+    words.push_back("charlie");
+    words.push_back("alpha");
+    check(words.linearSearch("charlie") == 2 && words.count("alpha") == 2 &&
+          words.min_index() == 1 && words.max_index() == 0,
+          "Default searches on a non-arithmetic type");
+    check_sort<std::int8_t>("Sorting int8_t");
+    check_sort<std::uint16_t>("Sorting uint16_t");
+    check_sort<std::int32_t>("Sorting int32_t");
+    check_sort<std::uint64_t>("Sorting uint64_t");
+    check_sort<std::int64_t>("Sorting int64_t");
+    check_sort<float>("Sorting float");
+    check_sort<double>("Sorting double");
+    check_sort<std::string>("Sorting strings");
+
+    dynamic_array<double> special;
+    special.push_back(0.0);
+    special.push_back(-0.0);
+    special.push_back(std::numeric_limits<double>::infinity());
+    special.push_back(-std::numeric_limits<double>::infinity());
+    special.push_back(-1e-300);
+    for (int i = 0; i < 300; i++) {
+        special.push_back(i);
+    }
+    special.sort();
+    check(special[0] == -std::numeric_limits<double>::infinity() && special[1] == -1e-300 &&
+          std::signbit(special[2]) && !std::signbit(special[3]) && std::isinf(special.last()),
+          "Radix sort orders infinities and signed zeros");
+
+    dynamic_array<std::pair<int, int>> pairs;
+    for (int i = 0; i < 100; i++) {
+        pairs.insert_sorted(std::make_pair(i % 10, i));
+    }
+    check(pairs[0] == std::make_pair(0, 0) && pairs[1] == std::make_pair(0, 10) && pairs.last() == std::make_pair(9, 99),
+          "Sorted insertion keeps the insertion order of equal items");
+    pairs.sort([](const std::pair<int, int> &a, const std::pair<int, int> &b) { return a.second > b.second; });
+    check(pairs[0].second == 99 && pairs.last().second == 0, "Sorting with a comparator");
+
+    check_erase<int>("Batch erasures on a trivially relocatable type");
+    check_erase<std::string>("Batch erasures on a non-trivial type");
+
+    dynamic_array<int> range;
+    range.push_back(1);
+    unsigned int bad = 1;
+    bool thrown = false;
+    try {
+        range.erase_indices(&bad, 1);
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown && range.size() == 1, "Erasing an index out of range throws and deletes nothing");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>
+#include "array_serialization.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+struct Point {
+    float x, y, z;
+};
+
+/// Return whether parsing the buffer throws std::runtime_error.
+bool rejected(const std::vector<std::uint64_t> &buffer, std::size_t bytes)
+{
+    try {
+        array_serialization::view<Point> points(buffer.data(), bytes);
+    }
+    catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    dynamic_array<Point> points;
+    for (int i = 0; i < 1000; i++) {
+        points.push_back(Point{float(i), float(i) * 2, -float(i)});
+    }
+    dynamic_array<std::uint32_t> ids;
+    for (std::uint32_t i = 0; i < 33; i++) {
+        ids.push_back(i * i);
+    }
+
+    // Two arrays back to back, in a buffer aligned for the items.
+    std::size_t first_bytes = array_serialization::serialized_size<Point>(points.size());
+    std::size_t bytes = first_bytes + array_serialization::serialized_size<std::uint32_t>(ids.size());
+    std::vector<std::uint64_t> buffer((bytes + 7) / 8 + 1);
+    unsigned char *out = reinterpret_cast<unsigned char*>(buffer.data());
+    std::size_t written = array_serialization::serialize(points, out, bytes);
+    written += array_serialization::serialize(ids, out + written, bytes - written);
+    check(written == bytes && first_bytes == 16 + 1000 * sizeof(Point), "Arrays are serialized");
+
+    array_serialization::view<Point> view(out, bytes);
+    check(view.size() == 1000 && view[999].y == 1998.0f &&
+          static_cast<const void*>(view.data()) == out + 16, "A view aliases the buffer");
+    dynamic_array<std::uint32_t> copy;
+    std::size_t read = array_serialization::read(out + view.serialized_bytes(),
+                                                 bytes - view.serialized_bytes(), copy);
+    check(read == bytes - first_bytes && copy.size() == 33 && copy[32] == 1024,
+          "The next array is read back");
+
+    // Arrays of different item sizes back to back: each one starts 16-byte aligned.
+    dynamic_array<char> letters;
+    letters.append("abc", 3);
+    dynamic_array<std::uint64_t> wide;
+    wide.push_back(0x0123456789abcdefull);
+    wide.push_back(42);
+    dynamic_array<std::uint16_t> shorts;
+    shorts.push_back(7);
+    std::size_t mixed_bytes = array_serialization::serialized_size<char>(3) + array_serialization::serialized_size<std::uint64_t>(2) +
+                              array_serialization::serialized_size<std::uint16_t>(1) + array_serialization::serialized_size<Point>(1);
+    std::vector<std::uint64_t> mixed(mixed_bytes / 8 + 1, ~0ull);
+    unsigned char *at = reinterpret_cast<unsigned char*>(mixed.data());
+    std::size_t offset = array_serialization::serialize(letters, at, mixed_bytes);
+    offset += array_serialization::serialize(wide, at + offset, mixed_bytes - offset);
+    offset += array_serialization::serialize(shorts, at + offset, mixed_bytes - offset);
+    offset += array_serialization::serialize(points.data(), 1u, at + offset, mixed_bytes - offset);
+    dynamic_array<char> letters_copy;
+    dynamic_array<std::uint64_t> wide_copy;
+    dynamic_array<std::uint16_t> shorts_copy;
+    std::size_t next = array_serialization::read(at, mixed_bytes, letters_copy);
+    bool padded = next == 32 && at[19] == 0 && at[31] == 0;
+    next += array_serialization::read(at + next, mixed_bytes - next, wide_copy);
+    next += array_serialization::read(at + next, mixed_bytes - next, shorts_copy);
+    array_serialization::view<Point> last(at + next, mixed_bytes - next);
+    check(offset == mixed_bytes && padded && letters_copy.size() == 3 && letters_copy[2] == 'c' &&
+          wide_copy[0] == 0x0123456789abcdefull && wide_copy[1] == 42 && shorts_copy[0] == 7 &&
+          last.size() == 1 && last[0].z == 0 && next + last.serialized_bytes() == mixed_bytes,
+          "Arrays of mixed item sizes are read back to back");
+
+    check(rejected(buffer, 10), "A truncated header is rejected");
+    check(rejected(buffer, first_bytes - 1), "Truncated items are rejected");
+    std::vector<std::uint64_t> other = buffer;
+    reinterpret_cast<unsigned char*>(other.data())[5] ^= 3;
+    check(rejected(other, bytes), "Another byte order is rejected");
+    other = buffer;
+    reinterpret_cast<unsigned char*>(other.data())[6] = 4;
+    check(rejected(other, bytes), "Another item size is rejected");
+    other = buffer;
+    other[0] = 0;
+    check(rejected(other, bytes), "A bad magic is rejected");
+
+    bool thrown = false;
+    try {
+        array_serialization::serialize(points, out, first_bytes - 1);
+    }
+    catch (const std::length_error &) {
+        thrown = true;
+    }
+    check(thrown, "Serializing into a small buffer throws");
+
+    char path[] = "/tmp/test_array_serialization.XXXXXX";
+    int fd = ::mkstemp(path);
+    ::unlink(path);
+    array_serialization::write(fd, points);
+    array_serialization::write(fd, dynamic_array<Point>());
+    std::vector<std::uint64_t> received((first_bytes + 16) / 8);
+    ::lseek(fd, 0, SEEK_SET);
+    bool complete = ::read(fd, received.data(), first_bytes + 16) == ssize_t(first_bytes + 16);
+    ::close(fd);
+    array_serialization::view<Point> sent(received.data(), first_bytes);
+    array_serialization::view<Point> empty(reinterpret_cast<unsigned char*>(received.data()) + first_bytes, 16);
+    check(complete && sent.size() == 1000 && sent[500].z == -500.0f && empty.size() == 0,
+          "Arrays are written to a file descriptor");
+    return failures ? 1 : 0;
+}
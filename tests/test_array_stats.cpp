@@ -0,0 +1,85 @@
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "dynamic_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+ARRAY_STATS_SITE(ints_site);
+ARRAY_STATS_SITE(strings_site);
+ARRAY_STATS_SITE(reserved_site);
+ARRAY_STATS_SITE(idle_site);
+
+/// std::allocator cannot resize blocks, so growing always relocates the items.
+template <typename T, typename Site>
+using counted_array = dynamic_array<T, unsigned int, std::allocator<T>, doubling_growth, site_stats<Site>>;
+
+/// The policy is stateless: an instrumented array is no bigger than a plain one.
+static_assert(sizeof(counted_array<int, ints_site>) == sizeof(dynamic_array<int>),
+              "statistics must not add per-array state");
+
+int main(int argc, char *argv[])
+{
+    array_stats_site &ints = site_stats<ints_site>::site();
+    {
+        counted_array<int, ints_site> a;
+        for (int i = 0; i < 100; i++) {
+            a.push_back(i);
+        }
+        // Capacities 1, 2, 4, ..., 128: eight allocations, each but the first relocating.
+        check(ints.grows == 8 && ints.allocations == 8, "Grows and allocations are counted");
+        check(ints.bytes_allocated == 255 * sizeof(int) && ints.bytes_freed == 127 * sizeof(int),
+              "Allocated and freed bytes are counted");
+        check(ints.moves == 0 && ints.bytes_relocated == 127 * sizeof(int),
+              "Trivially relocatable items are relocated bytewise");
+        counted_array<int, ints_site> b(a);
+        check(ints.copies == 100, "Copies are counted");
+        b.append(a.data(), 10);
+        check(ints.copies == 110, "Appended items are counted as copies");
+    }
+    check(ints.bytes_allocated == ints.bytes_freed, "Every allocated byte is freed");
+    // The copy is made with capacity 100, which grows to 200 on append().
+    check(ints.peak_capacity == 200 && ints.peak_size == 110, "Peak capacity and size are recorded");
+
+    array_stats_site &strings = site_stats<strings_site>::site();
+    {
+        counted_array<std::string, strings_site> s(4);
+        for (int i = 0; i < 5; i++) {
+            s.push_back(std::to_string(i));
+        }
+        check(strings.grows == 1 && strings.allocations == 2 && strings.moves == 4 &&
+              strings.bytes_relocated == 0,
+              "Other items are relocated by moves");
+    }
+
+    array_stats_site &reserved = site_stats<reserved_site>::site();
+    {
+        // Reserved up front, so it never grows, and emptied before it is destroyed.
+        counted_array<int, reserved_site> r(1000);
+        for (int i = 0; i < 500; i++) {
+            r.push_back(i);
+        }
+        r.clear();
+    }
+    check(reserved.grows == 0 && reserved.peak_size == 500 && reserved.peak_capacity == 1000,
+          "The peak size of a reserved array emptied before release is recorded");
+
+    std::ostringstream out;
+    array_stats_registry::dump(out);
+    std::string dump = out.str();
+    printf("%s", dump.c_str());
+    check(dump.find("ints_site (") < dump.find("strings_site ("),
+          "The dump lists the sites growing most often first");
+    check(dump.find("idle_site") == std::string::npos, "Unused sites are not registered");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include "dynamic_array.h"
+#include "small_dynamic_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// A read-only consumer taking a view instead of an array.
+long sum(array_view<const int> values)
+{
+    long total = 0;
+    for (int x : values) {
+        total += x;
+    }
+    return total;
+}
+
+void scale(array_view<int> values, int factor)
+{
+    for (int &x : values) {
+        x *= factor;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    dynamic_array<int> a;
+    for (int i = 0; i < 100; i++) {
+        a.push_back(i);
+    }
+    const dynamic_array<int> &ca = a;
+    check(sum(a) == 4950 && sum(ca) == 4950, "Arrays convert to views implicitly");
+
+    array_view<const int> slice = ca.view().subview(10, 5);
+    check(slice.size() == 5 && slice.first() == 10 && slice.last() == 14 && slice.data() == a.data() + 10,
+          "A subview aliases the array");
+    check(sum(a.view().subview(90)) == 945 && a.view().subview(100).empty(), "A subview runs to the end");
+
+    scale(a.view().subview(0, 10), 2);
+    check(a[9] == 18 && a[10] == 10, "A mutable view modifies the items");
+
+    check(slice.linearSearch(12) == 2 && slice.linearSearch(99) == 5 && slice.binarySearch(13) == 3 &&
+          slice.count(14) == 1 && slice.min_index() == 0 && slice.max_index() == 4,
+          "Views run the same searches as the arrays");
+    check(slice.linearSearch(11, [](int x, int v) { return x > v; }) == 2 &&
+          slice.binarySearch(12, [](int x, int v) { return x - v; }) == 2,
+          "Views run the searches with predicates");
+
+    small_dynamic_array<std::string, 4> words;
+    words.push_back("b");
+    words.push_back("a");
+    array_view<const std::string> view = words;
+    check(view.size() == 2 && view.min_index() == 1 && view.linearSearch("b") == 0,
+          "Small arrays convert to views");
+
+    bool thrown = false;
+    try {
+        slice.subview(3, 3);
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown, "A subview past the end throws");
+    thrown = false;
+    try {
+        slice[5];
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown, "Indexing past the end throws");
+    check(array_view<int>().empty() && sum(dynamic_array<int>()) == 0, "Empty views");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include "concurrent_dynamic_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const int num_threads = 8;
+    const int per_thread = 20000;
+
+    concurrent_dynamic_array<long> results;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < num_threads; t++) {
+        producers.emplace_back([&results, t, per_thread]() {
+            for (int i = 0; i < per_thread; i++) {
+                unsigned int index = results.emplace_back(long(t) * per_thread + i);
+                // A published item can be read back while other threads keep appending.
+                if (results[index] != long(t) * per_thread + i) {
+                    std::abort();
+                }
+            }
+        });
+    }
+    for (std::thread &producer : producers) {
+        producer.join();
+    }
+    check(results.size() == unsigned(num_threads * per_thread), "Concurrent appends claim distinct indices");
+
+    std::vector<bool> seen(num_threads * per_thread);
+    bool ok = true;
+    for (unsigned int i = 0; i < results.size(); i++) {
+        ok = ok && results.is_published(i) && !seen[results[i]];
+        seen[results[i]] = true;
+    }
+    check(ok, "Every appended item is published once");
+
+    const long *first = &results[0];
+    dynamic_array<long> flat = results.flatten();
+    check(flat.size() == unsigned(num_threads * per_thread) && results.size() == 0,
+          "Flatten into a contiguous array");
+
+    results.emplace_back(42);
+    check(&results[0] == first && results[0] == 42, "Buckets are reused after flattening");
+
+    // Tiny buckets, so that threads keep reaching buckets being allocated by another one.
+    concurrent_dynamic_array<int, unsigned int, 0> tiny;
+    std::vector<std::thread> racers;
+    for (int t = 0; t < num_threads; t++) {
+        racers.emplace_back([&tiny]() {
+            for (int i = 0; i < 5000; i++) {
+                tiny.emplace_back(i);
+            }
+        });
+    }
+    for (std::thread &racer : racers) {
+        racer.join();
+    }
+    long tiny_total = 0;
+    bool tiny_ok = tiny.size() == unsigned(num_threads * 5000);
+    for (unsigned int i = 0; i < tiny.size(); i++) {
+        tiny_ok = tiny_ok && tiny.is_published(i);
+        tiny_total += tiny[i];
+    }
+    check(tiny_ok && tiny_total == long(num_threads) * 4999 * 5000 / 2, "Threads racing for new buckets share them");
+
+    concurrent_dynamic_array<std::string> names;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&names, t]() {
+            for (int i = 0; i < 1000; i++) {
+                names.emplace_back(std::to_string(t * 1000 + i));
+            }
+        });
+    }
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+    dynamic_array<std::string> flat_names = names.flatten();
+    size_t total = 0;
+    for (unsigned int i = 0; i < flat_names.size(); i++) {
+        total += std::stoul(flat_names[i]);
+    }
+    check(flat_names.size() == 4000 && total == 3999 * 4000 / 2, "Flatten non-trivial items");
+    return failures ? 1 : 0;
+}
@@ -1,7 +1,10 @@
 #include <iostream>
 #include <string>
 #include <cstdio>
+#include <cstring>
+#include <stdexcept>
 #include <math.h>
+#include <stdint.h>
 #include "dynamic_array.h"
 
 class Foo {
@@ -50,6 +53,107 @@ public:
 };
 
 
+/// A move-only handle owning a heap value; moving it is equivalent to copying its pointer, so
+/// it is declared trivially relocatable below.
+class Handle {
+public:
+    static int Moves;
+    static int Destructions;
+
+    Handle(int n) : m_value(new int(n)) {}
+    Handle(Handle &&other) : m_value(other.m_value) { other.m_value = nullptr; Moves++; }
+    Handle& operator=(Handle &&other) { std::swap(m_value, other.m_value); Moves++; return *this; }
+    ~Handle() { delete m_value; Destructions++; }
+    int value() const { return *m_value; }
+    static void Reset_stats()
+    {
+        Moves = 0;
+        Destructions = 0;
+    }
+    static void Print_stats(const char *msg)
+    {
+        printf("%s: moves:%d destructions:%d\n", msg, Moves, Destructions);
+    }
+
+private:
+    int *m_value;
+};
+
+template <>
+struct is_trivially_relocatable<Handle> : std::true_type {};
+
+/// A stateful allocator standing for a memory arena, counting the allocations made through it.
+/// It does not propagate on copy/move assignment or swap, like std::pmr::polymorphic_allocator.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(int *allocs) : m_allocs(allocs) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : m_allocs(other.m_allocs) {}
+    T *allocate(std::size_t n)
+    {
+        (*m_allocs)++;
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, std::size_t)
+    {
+        ::operator delete(ptr);
+    }
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return m_allocs == other.m_allocs; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return m_allocs != other.m_allocs; }
+
+    int *m_allocs;
+};
+
+/// A type counting its copies and moves, with a noexcept move constructor.
+struct Counted {
+    static int Copies;
+    static int Moves;
+
+    Counted(int n) : value(n) {}
+    Counted(const Counted &other) : value(other.value) { Copies++; }
+    Counted(Counted &&other) noexcept : value(other.value) { Moves++; }
+    int value;
+};
+
+int Counted::Copies = 0;
+int Counted::Moves = 0;
+
+/// A type whose copy constructor throws once a countdown of copies runs out, and whose move
+/// constructor may throw, so that growing copies it.
+struct Fragile {
+    static int CopiesLeft;
+
+    Fragile(int n) : value(n) {}
+    Fragile(const Fragile &other) : value(other.value)
+    {
+        if (CopiesLeft-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+    }
+    Fragile(Fragile &&other) : value(other.value) {}
+    int value;
+};
+
+int Fragile::CopiesLeft = -1;
+
+/// A trivially copyable type that cannot be assigned, only constructed.
+struct Fixed {
+    const int x;
+};
+
+/// An over-aligned type, such as a SIMD vector or cache-line-sized record.
+struct alignas(32) Vec8f {
+    float v[8];
+};
+
+int Handle::Moves = 0;
+int Handle::Destructions = 0;
+
 int Foo::DefAllocs = 0;
 int Foo::Allocs = 0;
 int Foo::Copies = 0;
@@ -68,7 +172,7 @@ void print_array(dynamic_array<Foo> &foos)
 
 int main(int argc, char *argv[])
 {
-    char buf[64];
+    char buf[128];
     length_t initial_capacity = 1000;
     length_t num_elements = 1000;
     Foo::Reset_stats();
@@ -111,5 +215,173 @@ int main(int argc, char *argv[])
     foos_temp.swap_remove(index);
     std::cout << "Swap-remove element " << index << " from array" << std::endl;
     print_array(foos_temp);
+
+    Handle::Reset_stats();
+    dynamic_array<Handle> handles;
+    for (length_t i = 0; i < num_elements; i++) {
+        handles.emplace_back(i);
+    }
+    sprintf(buf, "Relocated an array of %d handle(s) while growing", handles.size());
+    Handle::Print_stats(buf);
+
+    Handle::Reset_stats();
+    handles.shift_remove(12);
+    handles.swap_remove(9);
+    sprintf(buf, "Shift-removed and swap-removed handles - values at 9 and 12: %d %d",
+            handles[9].value(), handles[12].value());
+    Handle::Print_stats(buf);
+
+    int arena1 = 0, arena2 = 0;
+    using arena_array = dynamic_array<int, unsigned int, ArenaAllocator<int>>;
+    arena_array ints1((ArenaAllocator<int>(&arena1)));
+    arena_array ints2((ArenaAllocator<int>(&arena2)));
+    for (int i = 0; i < 100; i++) {
+        ints1.push_back(i);
+    }
+    ints2 = ints1;
+    ints2 = std::move(ints1);
+    printf("Copy- and move-assigned between arenas: arena 1 allocations:%d arena 2 allocations:%d"
+           " - last item: %d\n", arena1, arena2, ints2.last());
+
+    dynamic_array<Vec8f> vectors;
+    aligned_dynamic_array<float, 64> floats;
+    for (int i = 0; i < 100; i++) {
+        vectors.emplace_back();
+        floats.push_back(i);
+    }
+    printf("Storage alignment: vectors data() mod 32 = %d, floats data() mod 64 = %d\n",
+           int(reinterpret_cast<uintptr_t>(vectors.data()) % 32),
+           int(reinterpret_cast<uintptr_t>(floats.data()) % 64));
+
+    dynamic_array<int, unsigned int, aligned_allocator<int>, geometric_growth<3, 2, 64>> grown;
+    std::cout << "Capacities with 1.5x growth:";
+    for (int i = 0; i < 100; i++) {
+        if (grown.size() == grown.capacity()) {
+            std::cout << " " << grown.capacity();
+        }
+        grown.push_back(i);
+    }
+    std::cout << " " << grown.capacity() << std::endl;
+
+    unsigned char packet[256];
+    for (int i = 0; i < 256; i++) {
+        packet[i] = i;
+    }
+    dynamic_array<unsigned char> bytes;
+    bytes.reserve(1024);
+    bytes.append(packet, 256);
+    bytes.append(bytes.data(), bytes.data() + 128);
+    length_t header = bytes.size();
+    bytes.resize_uninitialized(header + 64);
+    memcpy(bytes.data() + header, packet + 192, 64);
+    printf("Appended bytes: size:%d capacity:%d - items at 300 and 400: %d %d\n",
+           bytes.size(), bytes.capacity(), bytes[300], bytes[400]);
+
+    Foo::Reset_stats();
+    dynamic_array<Foo> appended;
+    appended.append(foos_temp.data(), 10);
+    appended.append(foos_temp.data() + 10, foos_temp.data() + 20);
+    appended.append(appended.data(), appended.size());
+    appended.resize_default_init(50);
+    sprintf(buf, "Appended %d item(s) - capacity: %d", appended.size(), appended.capacity());
+    Foo::Print_stats(buf);
+
+    bool thrown = false;
+    try {
+        bytes[bytes.size()];
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    printf("Checked index past the end throws: %s\n", thrown ? "yes" : "no");
+    dynamic_array<int, length_t, aligned_allocator<int>, doubling_growth, no_stats, bounds_checked_in_debug> lenient(8);
+    lenient.push_back(1);
+    thrown = false;
+    try {
+        // Within the capacity, so only the address is out of the array in non-DEBUG builds.
+        int *past_end = &lenient[1];
+        (void)past_end;
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    printf("Index checked in DEBUG builds only throws: %s\n", thrown ? "yes" : "no");
+
+    Foo::Reset_stats();
+    dynamic_array<Foo> filled(5, Foo(7, "fill"));
+    dynamic_array<Foo> filled_copy = filled;
+    sprintf(buf, "Filled and copied %d item(s) - capacity of the copy: %d - item at 4: %d", filled_copy.size(),
+            filled_copy.capacity(), filled_copy[4].m_number);
+    Foo::Print_stats(buf);
+
+    dynamic_array<int> source(100, 3);
+    dynamic_array<int> target(200);
+    const int *buffer = target.data();
+    target = source;
+    printf("Copy-assigned ints into a large enough buffer: size:%d capacity:%d - same buffer: %s - last item: %d\n",
+           target.size(), target.capacity(), target.data() == buffer ? "yes" : "no", target.last());
+    dynamic_array<int> small_target;
+    small_target = source;
+    printf("Copy-assigned ints into an empty array: size:%d capacity:%d\n", small_target.size(),
+           small_target.capacity());
+
+    dynamic_array<Fixed> fixed(4, Fixed{3});
+    dynamic_array<Fixed> fixed_copy = fixed;
+    printf("Filled and copied unassignable items: size:%d - items at 0 and 3: %d %d\n", fixed_copy.size(),
+           fixed_copy[0].x, fixed_copy[3].x);
+
+    dynamic_array<Counted> counted;
+    counted.push_back(Counted(0));
+    Counted::Copies = Counted::Moves = 0;
+    counted.reserve(64);
+    counted.push_back(Counted(1));
+    counted.emplace_back_n(30, [](length_t i) { return Counted(int(i) + 2); });
+    int next = 32;
+    counted.append_generate(30, [&next]() { return Counted(next++); });
+    printf("Pushed and generated %d item(s) - copies:%d moves:%d - item at 40: %d\n",
+           counted.size(), Counted::Copies, Counted::Moves, counted[40].value);
+    thrown = false;
+    try {
+        counted.emplace_back_n(10, [](length_t i) {
+            if (i == 5) {
+                throw std::runtime_error("factory failed");
+            }
+            return Counted(int(i));
+        });
+    }
+    catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    printf("A throwing factory restores the size: %s (size:%d)\n",
+           thrown && counted.size() == 62 ? "yes" : "no", counted.size());
+
+    dynamic_array<std::string> strings;
+    strings.push_back("first");
+    while (strings.size() < strings.capacity()) {
+        strings.push_back("more");
+    }
+    strings.push_back(strings[0]);
+    strings.emplace_back(strings[0], 1, 3);
+    printf("Pushed items of the array itself while growing: %s %s\n", strings[strings.size() - 2].c_str(),
+           strings.last().c_str());
+
+    dynamic_array<Fragile> fragile;
+    for (int i = 0; i < 16; i++) {
+        fragile.emplace_back(i);
+    }
+    Fragile::CopiesLeft = 8;
+    thrown = false;
+    try {
+        fragile.reserve(32);
+    }
+    catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    Fragile::CopiesLeft = -1;
+    bool intact = fragile.size() == 16 && fragile.capacity() == 16;
+    for (int i = 0; intact && i < 16; i++) {
+        intact = fragile[i].value == i;
+    }
+    printf("A copy throwing while growing leaves the array as it was: %s\n", thrown && intact ? "yes" : "no");
     return 0;
 }
@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include "flat_hash_map.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// A hash sending every key to the same group, so that all lookups collide.
+struct constant_hash {
+    std::size_t operator()(int) const { return 42; }
+};
+
+/// Return whether a map holds the same entries as a reference map.
+template <typename Map, typename Reference>
+bool same_entries(const Map &map, const Reference &reference)
+{
+    if (map.size() != reference.size()) {
+        return false;
+    }
+    for (const auto &entry : map) {
+        auto it = reference.find(entry.first);
+        if (it == reference.end() || it->second != entry.second || map.index_of(entry.first) != &entry - map.begin()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    flat_hash_map<std::string, int> ages;
+    check(ages.empty() && ages.capacity() == 0 && ages.find("alice") == nullptr, "An empty map allocates nothing");
+    check(ages.insert("alice", 30) && ages.insert("bob", 25) && !ages.insert("alice", 99),
+          "Inserting a key twice keeps the first value");
+    ages["carol"] = 41;
+    ages["bob"]++;
+    check(ages.size() == 3 && ages.at("alice") == 30 && *ages.find("bob") == 26 && ages.at("carol") == 41,
+          "Values are found by key");
+    check(!ages.insert_or_assign("alice", 31) && ages.at("alice") == 31, "insert_or_assign() overwrites");
+    check(ages.begin()->first == "alice" && (ages.end() - 1)->first == "carol" && ages.entries().size() == 3,
+          "Entries are stored densely in insertion order");
+    bool thrown = false;
+    try {
+        ages.at("dave");
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown && !ages.contains("dave"), "Looking up a missing key with at() throws");
+    check(ages.erase("alice") && !ages.erase("alice") && !ages.contains("alice") && ages.at("carol") == 41 &&
+          ages.index_of("carol") == 0, "Erasing moves the last entry into the hole");
+
+    std::mt19937 rng(7);
+    flat_hash_map<int, int> map;
+    std::unordered_map<int, int> reference;
+    bool agrees = true;
+    for (int i = 0; i < 200000; i++) {
+        int key = int(rng() % 5000);
+        switch (rng() % 3) {
+        case 0:
+            agrees = agrees && map.insert(key, i) == reference.insert(std::make_pair(key, i)).second;
+            break;
+        case 1:
+            agrees = agrees && map.erase(key) == (reference.erase(key) == 1);
+            break;
+        default: {
+            const int *value = map.find(key);
+            auto it = reference.find(key);
+            agrees = agrees && (value ? it != reference.end() && *value == it->second : it == reference.end());
+        }
+        }
+    }
+    check(agrees && same_entries(map, reference), "Random inserts, erasures and lookups match std::unordered_map");
+    check(map.capacity() >= 16 && (map.capacity() & (map.capacity() - 1)) == 0 && map.capacity() <= 8192,
+          "Churn at a steady size reuses tombstones instead of growing");
+
+    map.clear();
+    check(map.empty() && !map.contains(1) && map.insert(1, 1) && map.at(1) == 1, "Clearing empties the map");
+
+    flat_hash_map<int, int, constant_hash> colliding;
+    for (int i = 0; i < 100; i++) {
+        colliding.insert(i, i * i);
+    }
+    bool found = true;
+    for (int i = 0; i < 100; i += 2) {
+        found = found && colliding.erase(i);
+    }
+    for (int i = 0; i < 100; i++) {
+        const int *value = colliding.find(i);
+        found = found && (i % 2 ? value && *value == i * i : !value);
+    }
+    check(found && colliding.size() == 50, "Keys probing past full groups are found after erasures");
+
+    flat_hash_map<int, int>::entries_type pairs;
+    for (int i = 0; i < 10000; i++) {
+        pairs.emplace_back(i % 7000, i);
+    }
+    flat_hash_map<int, int> bulk(std::move(pairs));
+    bool first_kept = bulk.size() == 7000;
+    for (int i = 0; first_kept && i < 7000; i++) {
+        first_kept = bulk.at(i) == i && bulk.index_of(i) == unsigned(i);
+    }
+    check(first_kept && pairs.size() == 0, "Bulk construction moves the entries and keeps the first of equal keys");
+    flat_hash_map<int, int> copy = bulk;
+    copy[3] = -3;
+    check(copy.size() == 7000 && copy.at(3) == -3 && bulk.at(3) == 3 && copy.at(6999) == 6999, "Copies are independent");
+
+    flat_hash_map<std::string, int> names;
+    names.reserve(1000);
+    unsigned int capacity = names.capacity();
+    for (int i = 0; i < 1000; i++) {
+        names[std::to_string(i)] = i;
+    }
+    check(names.capacity() == capacity && names.at("999") == 999 && names.at("0") == 0,
+          "reserve() sizes the table for the entries");
+    return failures ? 1 : 0;
+}
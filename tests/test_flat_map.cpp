@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include "flat_map.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    flat_map<std::string, int> ages;
+    check(ages.empty() && ages.find("alice") == nullptr && ages.lower_bound("alice") == 0, "An empty map finds nothing");
+    check(ages.insert("carol", 41) && ages.insert("alice", 30) && ages.insert("bob", 25) && !ages.insert("alice", 99),
+          "Inserting a key twice keeps the first value");
+    ages["dave"] = 50;
+    ages["bob"]++;
+    check(ages.size() == 4 && ages.at("alice") == 30 && *ages.find("bob") == 26 && ages.at("dave") == 50,
+          "Values are found by key");
+    check(ages.begin()->first == "alice" && ages.entries()[1].first == "bob" && (ages.end() - 1)->first == "dave",
+          "Entries are kept in key order");
+    check(ages.lower_bound("bob") == 1 && ages.upper_bound("bob") == 2 && ages.lower_bound("bz") == 2 &&
+          ages.upper_bound("zed") == 4 && ages.index_of("bz") == 4, "Bounds of keys in and not in the map");
+    check(!ages.insert_or_assign("alice", 31) && ages.at("alice") == 31, "insert_or_assign() overwrites");
+    bool thrown = false;
+    try {
+        ages.at("eve");
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown, "Looking up a missing key with at() throws");
+    check(ages.erase("bob") && !ages.erase("bob") && ages.entries()[1].first == "carol" && ages.size() == 3,
+          "Erasing shifts the entries back");
+
+    std::mt19937 rng(11);
+    flat_map<int, int> map;
+    std::map<int, int> reference;
+    bool agrees = true;
+    for (int i = 0; i < 50000; i++) {
+        int key = int(rng() % 2000);
+        switch (rng() % 3) {
+        case 0:
+            agrees = agrees && map.insert(key, i) == reference.insert(std::make_pair(key, i)).second;
+            break;
+        case 1:
+            agrees = agrees && map.erase(key) == (reference.erase(key) == 1);
+            break;
+        default: {
+            const int *value = map.find(key);
+            auto it = reference.find(key);
+            agrees = agrees && (value ? it != reference.end() && *value == it->second : it == reference.end());
+        }
+        }
+    }
+    bool same = map.size() == reference.size();
+    auto it = reference.begin();
+    for (const auto &entry : map) {
+        same = same && entry.first == it->first && entry.second == it->second;
+        ++it;
+    }
+    check(agrees && same, "Random inserts, erasures and lookups match std::map");
+
+    flat_map<int, int>::entries_type pairs;
+    for (int i = 9999; i >= 0; i--) {
+        pairs.emplace_back(i % 7000, i);
+    }
+    flat_map<int, int> bulk(std::move(pairs));
+    bool first_kept = bulk.size() == 7000;
+    for (int i = 0; first_kept && i < 7000; i++) {
+        first_kept = bulk.entries()[i].first == i && bulk.at(i) == (i < 3000 ? i + 7000 : i);
+    }
+    check(first_kept && pairs.size() == 0, "Bulk construction sorts the entries and keeps the first of equal keys");
+
+    flat_map<int, std::string, std::greater<int>> descending;
+    descending.insert(1, "one");
+    descending.insert(3, "three");
+    descending.insert(2, "two");
+    check(descending.entries()[0].second == "three" && descending.at(1) == "one" && descending.index_of(2) == 1,
+          "A custom comparison orders the entries");
+    return failures ? 1 : 0;
+}
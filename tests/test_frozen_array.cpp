@@ -0,0 +1,149 @@
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "frozen_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+long sum(array_view<const int> values)
+{
+    long total = 0;
+    for (int x : values) {
+        total += x;
+    }
+    return total;
+}
+
+int main(int argc, char *argv[])
+{
+    dynamic_array<int> a;
+    for (int i = 0; i < 100; i++) {
+        a.push_back(i);
+    }
+    const int *items = a.data();
+    frozen_array<int> snapshot = std::move(a).freeze();
+    check(a.size() == 0 && snapshot.size() == 100 && snapshot.data() == items,
+          "Freezing an rvalue array moves the items into the snapshot");
+
+    frozen_array<int> copy = snapshot;
+    check(copy.shares(snapshot) && copy.data() == items && copy[42] == 42 && copy.last() == 99,
+          "Copies share the items");
+    check(sum(copy) == 4950 && copy.binarySearch(17) == 17 && copy.linearSearch(99) == 99 && copy.count(3) == 1,
+          "Snapshots are read like arrays");
+
+    copy.edit().push_back(100);
+    check(!copy.shares(snapshot) && copy.size() == 101 && snapshot.size() == 100 && snapshot.data() == items,
+          "Editing a shared snapshot copies the items first");
+    const int *edited = copy.data();
+    copy.edit()[0] = -1;
+    check(copy.data() == edited && copy[0] == -1, "Editing an unshared snapshot copies nothing");
+
+    dynamic_array<int> thawed = snapshot.thaw();
+    check(thawed.size() == 100 && thawed.data() != items && snapshot.size() == 100,
+          "Thawing a shared snapshot copies the items");
+    dynamic_array<int> moved = std::move(copy).thaw();
+    check(moved.data() == edited && moved.size() == 101 && copy.empty(),
+          "Thawing the only owner moves the items out");
+
+    dynamic_array<std::string> words;
+    words.push_back("alpha");
+    words.push_back("beta");
+    frozen_array<std::string> frozen_words = words.freeze();
+    words.push_back("gamma");
+    check(words.size() == 3 && frozen_words.size() == 2 && frozen_words[1] == "beta",
+          "Freezing an lvalue array copies the items");
+
+    frozen_array<int> empty;
+    check(empty.size() == 0 && empty.begin() == empty.end() && sum(empty) == 0 && empty.thaw().size() == 0,
+          "Empty snapshots");
+    empty.edit().push_back(7);
+    check(empty.size() == 1 && empty[0] == 7, "Editing an empty snapshot");
+
+    bool thrown = false;
+    try {
+        snapshot[100];
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown, "Indexing past the end throws");
+
+    // Readers copy the snapshot and read it concurrently.
+    std::vector<std::thread> readers;
+    std::vector<long> sums(4);
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&snapshot, &sums, t] {
+            for (int i = 0; i < 1000; i++) {
+                frozen_array<int> mine = snapshot;
+                sums[t] += sum(mine);
+            }
+        });
+    }
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+    check(sums[0] == 4950000 && sums[3] == 4950000 && snapshot.data() == items,
+          "Snapshots are copied and read from many threads");
+
+    // Each thread edits its own copy of shared items, while the others read theirs.
+    std::vector<std::thread> editors;
+    std::vector<int> edited_ok(4);
+    for (int t = 0; t < 4; t++) {
+        editors.emplace_back([&snapshot, &edited_ok, t] {
+            bool ok = true;
+            for (int i = 0; i < 200; i++) {
+                frozen_array<int> mine = snapshot;
+                mine.edit()[i % 100] += t + 1;
+                ok = ok && !mine.shares(snapshot) && sum(mine) == 4950 + t + 1 && sum(snapshot) == 4950;
+            }
+            edited_ok[t] = ok;
+        });
+    }
+    for (std::thread &editor : editors) {
+        editor.join();
+    }
+    check(edited_ok == std::vector<int>(4, 1) && snapshot.data() == items,
+          "Snapshots of shared items are edited from many threads");
+
+    // The owner lends copies to a reader thread, which drops them after reading, and edits its
+    // snapshot in between: once the reader has dropped its copy, the owner writes in place,
+    // which must happen after the reader's reads.
+    frozen_array<int> owned(dynamic_array<int>(100, 1));
+    std::atomic<frozen_array<int>*> lent(nullptr);
+    const int lends = 2000;
+    long read_total = 0;
+    std::thread reader([&lent, &read_total, lends] {
+        for (int i = 0; i < lends; i++) {
+            frozen_array<int> *copy;
+            while (!(copy = lent.exchange(nullptr, std::memory_order_acquire))) {
+                std::this_thread::yield();
+            }
+            read_total += sum(*copy);
+            delete copy;
+        }
+    });
+    for (int i = 0; i < lends; i++) {
+        while (lent.load(std::memory_order_relaxed)) {
+            std::this_thread::yield();
+        }
+        frozen_array<int> *copy = new frozen_array<int>(owned);
+        lent.store(copy, std::memory_order_release);
+        owned.edit()[0] = 1;
+    }
+    reader.join();
+    check(read_total == long(lends) * 100 && owned.size() == 100 && sum(owned) == 100,
+          "An owner edits in place once the copies lent to another thread are dropped");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "dynamic_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+ARRAY_STATS_SITE(shrinking_site);
+
+template <typename T, typename G>
+using grown_array = dynamic_array<T, unsigned int, aligned_allocator<T>, G>;
+
+int main(int argc, char *argv[])
+{
+    check(doubling_growth::next_capacity<int>(0u, 1u) == 1 && doubling_growth::next_capacity<int>(8u, 9u) == 16 &&
+          doubling_growth::next_capacity<int>(8u, 100u) == 100,
+          "Doubling growth");
+    check(doubling_growth::next_capacity<int>((unsigned char)(200), (unsigned char)(201)) == 255,
+          "Doubling growth saturates");
+    check(geometric_growth<>::next_capacity<int>(0u, 1u) == 16 && geometric_growth<>::next_capacity<int>(16u, 17u) == 24,
+          "Geometric growth");
+    static_assert(!growth_policy_shrinks<doubling_growth>::value, "doubling growth never shrinks");
+    static_assert(growth_policy_shrinks<shrinking_growth<>>::value, "shrinking growth shrinks");
+
+    dynamic_array<std::string> strings;
+    for (int i = 0; i < 100; i++) {
+        strings.push_back(std::to_string(i));
+    }
+    strings.erase(10, 100);
+    check(strings.capacity() == 128, "Deleting items keeps the capacity by default");
+    strings.shrink_to_fit();
+    check(strings.capacity() == 10 && strings[9] == "9", "shrink_to_fit() reduces the capacity to the size");
+    strings.clear();
+    strings.shrink_to_fit();
+    check(strings.capacity() == 0 && strings.data() == nullptr, "shrink_to_fit() releases the buffer of an empty array");
+
+    dynamic_array<int> ints;
+    ints.reserve(1000);
+    for (int i = 0; i < 300; i++) {
+        ints.push_back(i);
+    }
+    int *before = ints.data();
+    ints.shrink_to_fit();
+    check(ints.capacity() == 300 && ints[299] == 299, "shrink_to_fit() reallocates trivially relocatable items");
+    printf("Shrunk in place: %s\n", ints.data() == before ? "yes" : "no");
+
+    grown_array<int, shrinking_growth<>> shrinking;
+    for (int i = 0; i < 1024; i++) {
+        shrinking.push_back(i);
+    }
+    while (shrinking.size() > 256) {
+        shrinking.pop_back();
+    }
+    check(shrinking.capacity() == 1024, "Shrinking waits until the items fill less than a quarter");
+    shrinking.pop_back();
+    check(shrinking.capacity() == 512 && shrinking[254] == 254, "Then the capacity is halved");
+
+    // Alternating at the boundary reallocates at most once.
+    using counted = dynamic_array<int, unsigned int, aligned_allocator<int>, shrinking_growth<>,
+                                  site_stats<shrinking_site>>;
+    counted boundary;
+    for (int i = 0; i < 1024; i++) {
+        boundary.push_back(i);
+    }
+    array_stats_site &site = site_stats<shrinking_site>::site();
+    std::size_t grows = site.grows, shrinks = site.shrinks;
+    for (int i = 0; i < 1000; i++) {
+        boundary.resize_default_init(255);
+        boundary.resize_default_init(257);
+    }
+    check(site.grows == grows && site.shrinks == shrinks + 1 && boundary.capacity() == 512,
+          "Hysteresis: pushing and popping at a boundary does not reallocate each time");
+
+    boundary.clear();
+    check(boundary.capacity() < 4, "Clearing a shrinking array releases most of its buffer");
+    grown_array<int, shrinking_growth<doubling_growth, 4, 64>> kept;
+    for (int i = 0; i < 100; i++) {
+        kept.push_back(i);
+    }
+    kept.clear();
+    check(kept.capacity() == 16, "The capacity never shrinks below the minimum");
+    return failures ? 1 : 0;
+}
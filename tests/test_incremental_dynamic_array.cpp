@@ -0,0 +1,195 @@
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "incremental_dynamic_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// A type counting its moves, to measure the relocations of a single operation.
+struct Counted {
+    static int Moves;
+
+    Counted(int n) : value(n) {}
+    Counted(const Counted &other) = default;
+    Counted(Counted &&other) noexcept : value(other.value) { Moves++; }
+    int value;
+};
+
+int Counted::Moves = 0;
+
+/// A copy-only type counting its live objects, whose copy constructor throws once a countdown
+/// reaches zero.
+struct Tracked {
+    static int Live;
+    static int CopiesLeft;
+
+    Tracked(int n) : value(n) { Live++; }
+    Tracked(const Tracked &other) : value(other.value)
+    {
+        if (CopiesLeft >= 0 && CopiesLeft-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+        Live++;
+    }
+    Tracked &operator=(const Tracked &other) = default;
+    ~Tracked() { Live--; }
+    int value;
+};
+
+int Tracked::Live = 0;
+int Tracked::CopiesLeft = -1;
+
+template <typename Array, typename Reference>
+bool same_items(const Array &a, const Reference &reference)
+{
+    if (a.size() != reference.size()) {
+        return false;
+    }
+    for (unsigned int i = 0; i < a.size(); i++) {
+        if (!(a[i] == reference[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    incremental_dynamic_array<int> ints;
+    bool migrated = false;
+    bool ordered = true;
+    for (int i = 0; i < 100000; i++) {
+        ints.push_back(i);
+        migrated = migrated || ints.migrating();
+        ordered = ordered && ints[i] == i && ints[i / 2] == i / 2;
+    }
+    check(migrated && ordered && ints.size() == 100000, "Items are found in both buffers while migrating");
+    check(ints.data()[99999] == 99999 && !ints.migrating(), "data() finishes the migration");
+
+    incremental_dynamic_array<Counted, unsigned int, 8> counted;
+    int worst = 0;
+    unsigned int grows = 0;
+    for (int i = 0; i < 50000; i++) {
+        unsigned int capacity = counted.capacity();
+        Counted::Moves = 0;
+        counted.push_back(Counted(i));
+        worst = Counted::Moves > worst ? Counted::Moves : worst;
+        grows += counted.capacity() != capacity;
+        // Small arrays may migrate entirely within the growing push_back().
+        if (counted.capacity() != capacity && counted.size() > 64 && !counted.migrating()) {
+            worst = 1000000;
+        }
+    }
+    // One move of the new item, plus at most Step relocations with doubling growth.
+    check(worst <= 1 + 8 && grows == 17, "A push_back relocates a bounded number of items");
+
+    incremental_dynamic_array<int, unsigned int, 1, aligned_allocator<int>, geometric_growth<>> slow;
+    bool finished = true;
+    for (int i = 0; i < 20000; i++) {
+        unsigned int capacity = slow.capacity();
+        bool was_migrating = slow.migrating();
+        slow.push_back(i);
+        finished = finished && !(was_migrating && slow.capacity() != capacity);
+    }
+    check(finished && same_items(slow, [] { std::vector<int> v(20000); for (int i = 0; i < 20000; i++) v[i] = i; return v; }()),
+          "Migrations end before the next growth, even with slower growth and Step = 1");
+
+    std::mt19937 rng(5);
+    incremental_dynamic_array<std::string> strings;
+    std::vector<std::string> reference;
+    bool agrees = true;
+    for (int i = 0; i < 100000; i++) {
+        unsigned int op = rng() % 8;
+        if (op < 5 || reference.empty()) {
+            if (!reference.empty() && op == 0) {
+                // Push an item of the array itself, which may be migrating.
+                unsigned int index = rng() % reference.size();
+                strings.push_back(strings[index]);
+                reference.push_back(reference[index]);
+            }
+            else {
+                strings.emplace_back(std::to_string(i));
+                reference.push_back(std::to_string(i));
+            }
+        }
+        else if (op < 7) {
+            unsigned int index = rng() % reference.size();
+            strings.swap_remove(index);
+            reference[index] = reference.back();
+            reference.pop_back();
+        }
+        else {
+            strings.pop_back();
+            reference.pop_back();
+        }
+        if (i % 997 == 0) {
+            agrees = agrees && same_items(strings, reference);
+        }
+    }
+    check(agrees && same_items(strings, reference), "Random pushes and removals match std::vector");
+
+    incremental_dynamic_array<std::string> copy = strings;
+    incremental_dynamic_array<std::string> moved = std::move(strings);
+    std::size_t visited = 0;
+    moved.for_each([&visited](const std::string &s) { visited += s.size(); });
+    std::size_t expected = 0;
+    for (const std::string &s : reference) {
+        expected += s.size();
+    }
+    check(same_items(copy, reference) && !copy.migrating() && same_items(moved, reference) && strings.size() == 0 &&
+          visited == expected, "Copies, moves and for_each() see all the items");
+
+    incremental_dynamic_array<std::string> popped;
+    for (int i = 0; i < 33; i++) {
+        popped.push_back(std::to_string(i));
+    }
+    bool was_migrating = popped.migrating();
+    while (popped.size() > 1) {
+        popped.pop_back();
+    }
+    check(was_migrating && !popped.migrating() && popped[0] == "0", "Popping items out of the old buffer");
+    popped.clear();
+    popped.reserve(100);
+    check(popped.empty() && popped.capacity() == 100, "clear() and reserve()");
+
+    bool thrown = false;
+    try {
+        popped[0];
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown, "Checked index past the end throws");
+
+    {
+        incremental_dynamic_array<Tracked> tracked;
+        for (int i = 0; i < 40; i++) {
+            tracked.push_back(Tracked(i));
+        }
+        bool thrown = false;
+        Tracked::CopiesLeft = 0;
+        try {
+            tracked.swap_remove(3);
+        }
+        catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        Tracked::CopiesLeft = -1;
+        bool intact = thrown && tracked.size() == 40 && Tracked::Live == 40 && tracked[3].value == 3 && tracked[39].value == 39;
+        tracked.swap_remove(3);
+        check(intact && tracked.size() == 39 && Tracked::Live == 39 && tracked[3].value == 39,
+              "A throwing swap_remove() leaves the items intact");
+    }
+    check(Tracked::Live == 0, "All tracked items are destroyed once");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include "mapped_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+struct Record {
+    std::uint64_t id;
+    double price;
+    std::uint32_t quantity;
+};
+
+int main(int argc, char *argv[])
+{
+    std::string path = "/tmp/test_mapped_array." + std::to_string(::getpid());
+    ::unlink(path.c_str());
+    {
+        mapped_array<Record> records(path);
+        check(records.size() == 0 && records.capacity() == 0, "A new file holds an empty array");
+        for (std::uint32_t i = 0; i < 10000; i++) {
+            records.push_back(Record{i, i * 0.5, i % 7});
+        }
+        records.append(records.data(), 100);
+        records.flush();
+        check(records.size() == 10100 && records[10099].id == 99 && records[5000].price == 2500.0,
+              "Items are appended into the mapping");
+    }
+    {
+        mapped_array<Record> records(path);
+        records.advise(access_pattern::sequential);
+        bool ok = records.size() == 10100;
+        for (std::uint32_t i = 0; i < 10000 && ok; i++) {
+            ok = records[i].id == i && records[i].quantity == i % 7;
+        }
+        check(ok, "A reopened file holds the same items");
+        records.resize_uninitialized(10);
+        records.advise(access_pattern::random);
+    }
+    {
+        mapped_array<std::uint32_t> ids(path + ".ids");
+        for (std::uint32_t i = 0; i < 1000; i++) {
+            ids.push_back(i * 2);
+        }
+        check(ids.linearSearch(500) == 250 && ids.binarySearch(501) == 251 && ids.count(8) == 1,
+              "Searches run on the mapped items");
+        ::unlink((path + ".ids").c_str());
+    }
+    {
+        mapped_array<Record> records(path);
+        check(records.size() == 10 && records[9].id == 9, "The size is persisted");
+    }
+    bool thrown = false;
+    try {
+        mapped_array<std::uint16_t> wrong(path);
+    }
+    catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    check(thrown, "Opening a file of items of another size throws");
+    thrown = false;
+    try {
+        mapped_array<Record> missing("/nonexistent-directory/array");
+    }
+    catch (const std::system_error &) {
+        thrown = true;
+    }
+    check(thrown, "Failing to open the file throws std::system_error");
+    ::unlink(path.c_str());
+    return failures ? 1 : 0;
+}
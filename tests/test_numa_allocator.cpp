@@ -0,0 +1,102 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#include "dynamic_array.h"
+#include "numa_allocator.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+template <typename T>
+using numa_array = dynamic_array<T, std::size_t, numa_allocator<T>>;
+
+/// Fill an array by push_back(), growing it across the mapped threshold, and check the items.
+bool fill(const memory_placement &placement, std::size_t count)
+{
+    numa_array<std::uint64_t> a{numa_allocator<std::uint64_t>(placement)};
+    for (std::size_t i = 0; i < count; i++) {
+        a.push_back(i * 3);
+    }
+    bool ok = a.size() == count;
+    for (std::size_t i = 0; ok && i < count; i += 4099) {
+        ok = a[i] == i * 3;
+    }
+    return ok && a.last() == (count - 1) * 3;
+}
+
+bool aligned(const void *ptr, std::size_t alignment)
+{
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+/// Return the NUMA policy of the mapping at 'ptr', or -1 if the kernel has no NUMA support.
+int policy_of(void *ptr)
+{
+    int mode = -1;
+    if (::syscall(SYS_get_mempolicy, &mode, nullptr, 0, ptr, MPOL_F_ADDR) != 0) {
+        return -1;
+    }
+    return mode;
+}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t count = 1 << 20;
+    check(fill(memory_placement(), count), "Default placement");
+    check(fill(memory_placement::first_touch(), count), "First-touch placement");
+    check(fill(memory_placement::interleaved(), count), "Interleaved placement");
+    check(fill(memory_placement::bound_to(0), count), "Placement bound to node 0");
+    check(fill(memory_placement().with_pages(page_kind::transparent_huge), count), "Transparent huge pages");
+    check(fill(memory_placement::interleaved().with_pages(page_kind::huge_2mb), count),
+          "Explicit huge pages (falling back to transparent ones without a pool)");
+
+    numa_allocator<char> bound(memory_placement::bound_to(0));
+    char *block = bound.allocate(4 << 20);
+    std::memset(block, 1, 4 << 20);
+    int mode = policy_of(block);
+    check(aligned(block, 4096) && (mode == -1 || mode == MPOL_BIND), "A large block is mapped and bound");
+    bound.deallocate(block, 4 << 20);
+
+    numa_allocator<char> interleaved(memory_placement::interleaved());
+    block = interleaved.allocate(4 << 20);
+    mode = policy_of(block);
+    check(mode == -1 || mode == MPOL_INTERLEAVE, "A large block is interleaved");
+    char *grown = interleaved.reallocate(block, 4 << 20, 64 << 20);
+    mode = policy_of(grown + (60 << 20));
+    check(grown && (mode == -1 || mode == MPOL_INTERLEAVE), "A grown block keeps its policy");
+    interleaved.deallocate(grown, 64 << 20);
+
+    numa_allocator<char> huge(memory_placement().with_pages(page_kind::transparent_huge));
+    block = huge.allocate(3 << 20);
+    check(aligned(block, 2 << 20), "Blocks for transparent huge pages are aligned to 2 MB");
+    check(huge.reallocate(block, 3 << 20, (3 << 20) + 4096) == block,
+          "Resizing within the mapping keeps the block");
+    huge.deallocate(block, (3 << 20) + 4096);
+
+    numa_allocator<int> small(memory_placement::interleaved());
+    int *items = small.allocate(10);
+    items[9] = 9;
+    check(items[9] == 9 && small.reallocate(items, 10, 1 << 20) == nullptr,
+          "Small blocks come from malloc and are not resized into mappings");
+    small.deallocate(items, 10);
+
+    check(numa_allocator<int>(memory_placement::bound_to(0)) == numa_allocator<long>(memory_placement::bound_to(0)) &&
+          numa_allocator<int>(memory_placement::bound_to(0)) != numa_allocator<int>(memory_placement::interleaved()),
+          "Allocators compare equal if their placements do");
+    numa_array<int> a{numa_allocator<int>(memory_placement::interleaved())};
+    numa_array<int> b;
+    a.push_back(1);
+    b = a;
+    check(b.get_allocator() == a.get_allocator(), "The placement propagates on assignment");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "array_view.h"
+#include "dynamic_array.h"
+#include "parallel_algorithms.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    dynamic_array<int> a;
+    for (int i = 0; i < 1000; i++) {
+        a.push_back(999 - i);
+    }
+    long sum = 0;
+    for (int x : a) {
+        sum += x;
+    }
+    check(sum == 499500 && a.end() - a.begin() == 1000, "Range-for over an array");
+    std::sort(a.begin(), a.end());
+    std::transform(a.begin(), a.end(), a.begin(), [](int x) { return x * 2; });
+    check(std::is_sorted(a.cbegin(), a.cend()) && a.at_unchecked(10) == 20 && a.last() == 1998,
+          "Standard algorithms on array iterators");
+
+    std::mt19937 rng(3);
+    bool ok = true;
+    for (unsigned int threads = 1; threads <= 7 && ok; threads++) {
+        for (std::size_t size : {0, 1, 100, 4096 * 3 + 17, 100000}) {
+            dynamic_array<unsigned int> values;
+            for (std::size_t i = 0; i < size; i++) {
+                values.push_back(rng() % 1000);
+            }
+            std::vector<unsigned int> expected(values.begin(), values.end());
+            std::sort(expected.begin(), expected.end(), std::greater<unsigned int>());
+            parallel_algorithms::sort(values.begin(), values.end(), std::greater<unsigned int>(), threads);
+            ok = ok && std::equal(expected.begin(), expected.end(), values.begin());
+        }
+    }
+    check(ok, "Parallel sort matches std::sort for any number of threads");
+
+    dynamic_array<std::string> words;
+    for (int i = 0; i < 20000; i++) {
+        words.push_back(std::to_string(rng()));
+    }
+    parallel_algorithms::sort(words.begin(), words.end());
+    check(std::is_sorted(words.begin(), words.end()), "Parallel sort of non-trivial items");
+
+    dynamic_array<int> counters;
+    for (int i = 0; i < 50000; i++) {
+        counters.push_back(i);
+    }
+    std::atomic<long> visited(0);
+    parallel_algorithms::for_each(counters.begin(), counters.end(), [&visited](int &x) {
+        x += 1;
+        visited++;
+    }, 4);
+    check(visited == 50000 && counters[0] == 1 && counters.last() == 50000,
+          "Parallel for_each visits every item once");
+
+    bool thrown = false;
+    try {
+        parallel_algorithms::for_each(counters.begin(), counters.end(), [](int x) {
+            if (x == 40000) {
+                throw std::runtime_error("failed");
+            }
+        }, 4);
+    }
+    catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    check(thrown, "An exception thrown on a worker thread is rethrown");
+
+    parallel_algorithms::thread_pool pool(3);
+    std::vector<std::atomic<int>> hits(100000);
+    pool.parallel_for(hits.size(), 16, 4, [&hits](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            // The first chunk is much slower, so the other threads steal from it.
+            if (i < 25000) {
+                std::this_thread::sleep_for(std::chrono::microseconds(1));
+            }
+            hits[i]++;
+        }
+    });
+    check(std::all_of(hits.begin(), hits.end(), [](const std::atomic<int> &h) { return h == 1; }) && pool.workers() == 3,
+          "A pool loop with uneven work covers every index once");
+    std::atomic<long> nested(0);
+    pool.parallel_for(64, 16, 4, [&pool, &nested](std::size_t begin, std::size_t end) {
+        pool.parallel_for(end - begin, 1, 4, [&nested](std::size_t b, std::size_t e) { nested += long(e - b); });
+    });
+    check(nested == 64, "Loops nested in a loop of the same pool share its workers");
+
+    // Each loop has two calls, and each call waits for the other one to start: the loops only
+    // finish if both get a worker while the other one is running.
+    std::atomic<int> started[2] = {{0}, {0}};
+    std::atomic<bool> met[2] = {{false}, {false}};
+    auto meet = [&pool, &started, &met](int loop) {
+        pool.parallel_for(2, 1, 2, [&started, &met, loop](std::size_t, std::size_t) {
+            started[loop]++;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (started[loop] < 2 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+            if (started[loop] == 2) {
+                met[loop] = true;
+            }
+        });
+    };
+    std::thread first(meet, 0), second(meet, 1);
+    first.join();
+    second.join();
+    check(met[0] && met[1], "Loops started concurrently from two threads both run in parallel");
+
+    std::vector<unsigned int> input(100000);
+    for (unsigned int &x : input) {
+        x = rng() % 1000;
+    }
+    array_view<const unsigned int> view(input.data(), unsigned(input.size()));
+    ok = true;
+    double reduced = 0;
+    for (unsigned int threads = 1; threads <= 7 && ok; threads++) {
+        for (std::size_t size : {0, 1, 100, 4096 * 3 + 17, 100000}) {
+            dynamic_array<unsigned int> doubled(unsigned(size), 0u);
+            unsigned int *end = parallel_algorithms::transform(view.begin(), view.begin() + size, doubled.begin(),
+                                                                [](unsigned int x) { return x * 2; }, threads);
+            ok = ok && end == doubled.end() && std::equal(doubled.begin(), doubled.end(), input.begin(),
+                                                          [](unsigned int d, unsigned int x) { return d == x * 2; });
+
+            long sum = parallel_algorithms::reduce(view.begin(), view.begin() + size, 5L,
+                                                   [](long a, unsigned int b) { return a + b; }, threads);
+            ok = ok && sum == std::accumulate(input.begin(), input.begin() + size, 5L);
+
+            dynamic_array<unsigned int> odd(unsigned(size), 0u);
+            auto is_odd = [](unsigned int x) { return x % 2 == 1; };
+            std::vector<unsigned int> expected;
+            std::copy_if(input.begin(), input.begin() + size, std::back_inserter(expected), is_odd);
+            unsigned int *last = parallel_algorithms::copy_if(view.begin(), view.begin() + size, odd.begin(), is_odd, threads);
+            ok = ok && std::size_t(last - odd.begin()) == expected.size() && std::equal(expected.begin(), expected.end(), odd.begin());
+        }
+        // Floating-point sums are combined in the same order for any number of threads.
+        double total = parallel_algorithms::reduce(view.begin(), view.end(), 0.5, [](double a, double b) { return a + b / 3; }, threads);
+        ok = ok && (threads == 1 || total == reduced);
+        reduced = total;
+    }
+    check(ok, "Parallel transform, reduce and copy_if match the standard algorithms");
+
+    dynamic_array<std::string> names = words;
+    dynamic_array<std::string> chosen(names.size(), std::string());
+    parallel_algorithms::transform(names.begin(), names.end(), names.begin(), [](const std::string &s) { return s + "!"; });
+    std::string *found = parallel_algorithms::copy_if(names.begin(), names.end(), chosen.begin(),
+                                                      [](const std::string &s) { return s[0] == '1'; });
+    check(std::all_of(chosen.begin(), found, [](const std::string &s) { return s[0] == '1' && s.back() == '!'; }) &&
+          found - chosen.begin() == std::count_if(words.begin(), words.end(), [](const std::string &s) { return s[0] == '1'; }),
+          "Parallel transform and copy_if of non-trivial items");
+
+    thrown = false;
+    try {
+        dynamic_array<int> out(counters.size(), 0);
+        parallel_algorithms::copy_if(counters.begin(), counters.end(), out.begin(), [](int x) {
+            if (x == 40000) {
+                throw std::runtime_error("failed");
+            }
+            return true;
+        }, 4);
+    }
+    catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    check(thrown, "An exception thrown by a predicate is rethrown");
+    return failures ? 1 : 0;
+}
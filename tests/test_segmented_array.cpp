@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include "segmented_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// A copy-only type counting its live objects, whose copy constructor throws once a countdown
+/// reaches zero.
+struct Tracked {
+    static int Live;
+    static int CopiesLeft;
+
+    Tracked(int n) : value(n) { Live++; }
+    Tracked(const Tracked &other) : value(other.value)
+    {
+        if (CopiesLeft >= 0 && CopiesLeft-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+        Live++;
+    }
+    Tracked &operator=(const Tracked &other) = default;
+    ~Tracked() { Live--; }
+    int value;
+};
+
+int Tracked::Live = 0;
+int Tracked::CopiesLeft = -1;
+
+/// Small chunks, so that a few hundred items span many of them.
+template <typename T>
+using small_chunks = segmented_array<T, unsigned int, 4>;
+
+int main(int argc, char *argv[])
+{
+    small_chunks<int> a;
+    a.push_back(0);
+    const int *first = &a[0];
+    for (int i = 1; i < 1000; i++) {
+        a.push_back(i);
+    }
+    check(a.size() == 1000 && a.capacity() == 1008 && a.chunk_count() == 63,
+          "Growing allocates one chunk at a time");
+    check(&a[0] == first && a[999] == 999 && a.last() == 999, "Growing never moves items");
+    check(a.chunk(62).size() == 8 && a.chunk(62).first() == 992 && a.chunk(1).data() == &a[16],
+          "Chunks are views of contiguous items");
+
+    a.push_back(a[10]);
+    check(a.last() == 10, "Pushing back an item of the array itself");
+    a.pop_back();
+
+    check(a.linearSearch(500) == 500 && a.linearSearch(1000) == 1000 && a.count(7) == 1,
+          "Linear searches and counts span the chunks");
+    check(a.linearSearch(300, [](int x, int v) { return x > v; }) == 301,
+          "Linear search with a predicate");
+    bool found = true;
+    for (int v = -1; v <= 1000; v++) {
+        unsigned int expected = unsigned(std::lower_bound(a.begin(), a.end(), v) - a.begin());
+        found = found && a.binarySearch(v) == std::min(expected, a.size() - 1);
+    }
+    check(found, "Binary search matches std::lower_bound across the chunks");
+    check(a.binarySearch(37, [](int x, int v) { return x - v; }) == 37, "Binary search with a predicate");
+
+    a[600] = -5;
+    a[700] = 5000;
+    a[701] = 5000;
+    check(a.min_index() == 600 && a.max_index() == 700, "Minimum and maximum items across the chunks");
+
+    a.swap_remove(600);
+    check(a.size() == 999 && a[600] == 999 && a.last() == 998, "swap_remove moves the last item into the hole");
+    while (a.size() > 10) {
+        a.pop_back();
+    }
+    check(a.capacity() == 1008, "Emptied chunks are kept");
+    for (int i = 0; i < 990; i++) {
+        a.push_back(i);
+    }
+    check(a.capacity() == 1008 && &a[0] == first, "Kept chunks are reused");
+    a.clear();
+    a.shrink_to_fit();
+    check(a.empty() && a.capacity() == 0 && a.chunk_count() == 0, "shrink_to_fit releases the unused chunks");
+
+    small_chunks<int> b;
+    for (int i = 0; i < 200; i++) {
+        b.push_back((i * 37) % 200);
+    }
+    std::sort(b.begin(), b.end());
+    check(std::is_sorted(b.cbegin(), b.cend()) && b[123] == 123 &&
+          std::accumulate(b.begin(), b.end(), 0) == 19900,
+          "Standard algorithms run on the iterators");
+
+    small_chunks<int> growing;
+    growing.push_back(0);
+    small_chunks<int>::iterator kept = growing.begin();
+    small_chunks<int>::const_iterator kept_const = growing.cbegin();
+    unsigned int directory = growing.chunk_count();
+    for (int i = 1; i < 10000; i++) {
+        growing.push_back(i);
+    }
+    // 625 chunks: the directory has been reallocated several times meanwhile.
+    check(growing.chunk_count() == 625 && directory == 1 && *kept == 0 && kept[9999] == 9999 &&
+          kept_const[5000] == 5000 && growing.end() - kept == 10000,
+          "Iterators stay valid while the chunk directory grows");
+
+    small_chunks<std::string> s;
+    for (int i = 0; i < 100; i++) {
+        s.emplace_back(40, char('a' + i % 26));
+    }
+    small_chunks<std::string> t(s);
+    s.swap_remove(3);
+    check(s.size() == 99 && s[3] == std::string(40, 'v') && t[3] == std::string(40, 'd'),
+          "Copies are independent");
+    small_chunks<std::string> u(std::move(t));
+    check(t.size() == 0 && u.size() == 100 && u.binarySearch(std::string(40, 'a')) == 0,
+          "A moved array takes over the chunks");
+    t = u;
+    u = std::move(s);
+    check(t.size() == 100 && u.size() == 99 && u.linearSearch(std::string(40, 'v')) == 3,
+          "Copy and move assignment");
+
+    bool thrown = false;
+    try {
+        u[99];
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown, "Indexing past the end throws");
+    thrown = false;
+    try {
+        small_chunks<int>().pop_back();
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown, "Popping from an empty array throws");
+    check(small_chunks<int>().binarySearch(3) == 0 && small_chunks<int>().min_index() == 0,
+          "Searching an empty array");
+
+    segmented_array<double> large;
+    for (int i = 0; i < 100000; i++) {
+        large.push_back(i * 0.5);
+    }
+    check(large.chunk_count() == 98 && large.binarySearch(25000.0) == 50000 && large.linearSearch(49999.5) == 99999,
+          "Default chunks of 1024 items");
+
+    {
+        small_chunks<Tracked> tracked;
+        for (int i = 0; i < 40; i++) {
+            tracked.push_back(Tracked(i));
+        }
+        bool thrown = false;
+        Tracked::CopiesLeft = 0;
+        try {
+            tracked.swap_remove(3);
+        }
+        catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        Tracked::CopiesLeft = -1;
+        bool intact = thrown && tracked.size() == 40 && Tracked::Live == 40 && tracked[3].value == 3 && tracked[39].value == 39;
+        tracked.swap_remove(3);
+        check(intact && tracked.size() == 39 && Tracked::Live == 39 && tracked[3].value == 39,
+              "A throwing swap_remove() leaves the items intact");
+    }
+    check(Tracked::Live == 0, "All tracked items are destroyed once");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "slot_map.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    slot_map<std::string> names;
+    auto alice = names.insert("alice");
+    auto bob = names.insert("bob");
+    auto carol = names.emplace(5, 'c');
+    check(names.size() == 3 && names[alice] == "alice" && names[bob] == "bob" && names[carol] == "ccccc",
+          "Values are found through their handles");
+
+    check(names.erase(alice) && !names.contains(alice) && names.find(alice) == nullptr,
+          "An erased value's handle is stale");
+    check(names[carol] == "ccccc" && names[bob] == "bob" && names.size() == 2,
+          "Handles survive the values moving on erasure");
+    check(!names.erase(alice), "Erasing through a stale handle does nothing");
+
+    auto dave = names.insert("dave");
+    check(dave.index == alice.index && dave != alice && !names.contains(alice) && names[dave] == "dave",
+          "A reused slot does not revive old handles");
+
+    bool thrown = false;
+    try {
+        names[alice];
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown, "Accessing a stale handle throws");
+
+    bool dense = true;
+    for (unsigned int i = 0; i < names.size(); i++) {
+        dense = dense && &names[names.handle_at(i)] == names.values().data() + i;
+    }
+    std::size_t visited = 0;
+    for (std::string &name : names) {
+        visited += name.size();
+    }
+    check(dense && visited == 3 + 5 + 4, "Values are stored densely");
+
+    names.clear();
+    check(names.empty() && !names.contains(bob) && !names.contains(dave), "Clearing makes all handles stale");
+    check(!names.contains(slot_map<std::string>::handle{0, 0}) && !names.contains(slot_map<std::string>::handle{99, 1}),
+          "Handles that were never handed out are stale");
+
+    // Random operations against a std::map keyed by the handles' index and generation.
+    std::mt19937 rng(5);
+    slot_map<int> values;
+    std::map<std::pair<unsigned, unsigned>, int> expected;
+    std::vector<slot_map<int>::handle> handles;
+    bool ok = true;
+    for (int step = 0; step < 20000 && ok; step++) {
+        if (handles.empty() || rng() % 3) {
+            int value = int(rng());
+            auto h = values.insert(value);
+            handles.push_back(h);
+            expected[{h.index, h.generation}] = value;
+        }
+        else {
+            auto h = handles[rng() % handles.size()];
+            bool live = expected.erase({h.index, h.generation}) > 0;
+            ok = values.erase(h) == live;
+        }
+        if (step % 1000 == 0) {
+            for (auto h : handles) {
+                auto it = expected.find({h.index, h.generation});
+                const int *found = values.find(h);
+                ok = ok && (it == expected.end() ? found == nullptr : found && *found == it->second);
+            }
+            ok = ok && values.size() == expected.size();
+        }
+    }
+    check(ok, "Random inserts and erasures match a map");
+    return failures ? 1 : 0;
+}
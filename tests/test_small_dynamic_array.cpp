@@ -0,0 +1,168 @@
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <stdexcept>
+#include <type_traits>
+#include "small_dynamic_array.h"
+
+/// An allocator counting the heap buffers requested and returned through it.
+template <typename T>
+class CountingAllocator : public std::allocator<T> {
+public:
+    static int Allocs;
+    static int Frees;
+
+    template <typename U>
+    struct rebind {
+        using other = CountingAllocator<U>;
+    };
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+    T *allocate(std::size_t n)
+    {
+        Allocs++;
+        return std::allocator<T>::allocate(n);
+    }
+    void deallocate(T *p, std::size_t n)
+    {
+        Frees++;
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+template <typename T>
+int CountingAllocator<T>::Allocs = 0;
+template <typename T>
+int CountingAllocator<T>::Frees = 0;
+
+/// A copy-only type whose copy constructor throws once a countdown reaches zero.
+struct Brittle {
+    static int CopiesLeft;
+
+    Brittle(int n) : value(n) {}
+    Brittle(const Brittle &other) : value(other.value)
+    {
+        if (CopiesLeft >= 0 && CopiesLeft-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+    }
+    int value;
+};
+
+int Brittle::CopiesLeft = -1;
+
+using names_t = small_dynamic_array<std::string, 4, unsigned int, CountingAllocator<std::string>>;
+using length_t = names_t::length_t;
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+void print_array(const names_t &names)
+{
+    std::cout << "Array: [ ";
+    for (length_t i = 0; i < names.size(); i++) {
+        std::cout << names[i] << " ";
+    }
+    std::cout << "] capacity: " << names.capacity()
+              << (names.is_inline() ? " (inline)" : " (heap)") << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *words[] = { "alpha", "bravo", "charlie", "delta", "echo", "foxtrot" };
+
+    names_t names;
+    for (int i = 0; i < 4; i++) {
+        names.emplace_back(words[i]);
+    }
+    print_array(names);
+    check(names.is_inline() && CountingAllocator<std::string>::Allocs == 0,
+          "Filling up to the inline capacity does not allocate");
+
+    names.push_back(words[4]);
+    names.push_back(words[5]);
+    print_array(names);
+    check(!names.is_inline() && CountingAllocator<std::string>::Allocs == 1 && names.capacity() == 8,
+          "Overflowing the inline capacity moves the items to the heap");
+
+    names_t copy = names;
+    copy.shift_remove(1);
+    copy.swap_remove(0);
+    print_array(copy);
+    check(copy.size() == 4 && copy[0] == "foxtrot" && copy[1] == "charlie" && copy.last() == "echo",
+          "Shift-remove and swap-remove on a copy");
+
+    names_t moved = std::move(names);
+    check(moved.size() == 6 && names.size() == 0 && names.is_inline(),
+          "Moving a heap array steals its buffer");
+
+    names_t small;
+    small.push_back(words[0]);
+    names_t small_moved = std::move(small);
+    check(small_moved.is_inline() && small_moved.first() == "alpha" && small.size() == 0,
+          "Moving an inline array relocates its items");
+
+    swap(small_moved, moved);
+    check(small_moved.size() == 6 && moved.size() == 1 && moved.is_inline(),
+          "Swap an inline and a heap array");
+
+    small_dynamic_array<int, 16> ints;
+    for (int i = 0; i < 16; i++) {
+        ints.push_back(i * 10);
+    }
+    length_t index = ints.binarySearch(70, [](int a, int b) { return a - b; });
+    length_t lindex = ints.linearSearch(150, [](int a, int b) { return a == b; });
+    check(ints.is_inline() && index == 7 && lindex == 15, "Binary and linear search inline items");
+
+    try {
+        ints[16];
+        check(false, "Out of range access throws");
+    }
+    catch (const std::out_of_range &) {
+        check(true, "Out of range access throws");
+    }
+
+    names_t aliased;
+    for (int i = 0; i < 4; i++) {
+        aliased.emplace_back(std::string(32, char('a' + i)));
+    }
+    // The array is full and inline: the arguments are items that move while spilling to the heap.
+    aliased.emplace_back(aliased[0]);
+    aliased.push_back(aliased.last());
+    check(!aliased.is_inline() && aliased.size() == 6 && aliased[4] == std::string(32, 'a') &&
+          aliased[5] == std::string(32, 'a'), "Add items of the array itself while spilling to the heap");
+
+    using brittle_t = small_dynamic_array<Brittle, 2, unsigned int, CountingAllocator<Brittle>>;
+    brittle_t brittle;
+    for (int i = 0; i < 4; i++) {
+        brittle.push_back(Brittle(i));
+    }
+    int allocs = CountingAllocator<Brittle>::Allocs;
+    int frees = CountingAllocator<Brittle>::Frees;
+    bool thrown = false;
+    Brittle::CopiesLeft = 2;
+    try {
+        brittle.push_back(Brittle(4));
+    }
+    catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    Brittle::CopiesLeft = -1;
+    check(thrown && CountingAllocator<Brittle>::Allocs - allocs == CountingAllocator<Brittle>::Frees - frees &&
+          brittle.size() == 4 && brittle[3].value == 3, "A throwing copy while growing frees the new buffer");
+
+    static_assert(std::is_nothrow_move_constructible<small_dynamic_array<std::string, 4>>::value,
+                  "moving an array of nothrow-movable items does not throw");
+    static_assert(!std::is_nothrow_move_constructible<brittle_t>::value,
+                  "moving an array of copy-only items may throw");
+    return failures ? 1 : 0;
+}
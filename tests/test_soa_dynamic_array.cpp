@@ -0,0 +1,68 @@
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include "soa_dynamic_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+/// Particles: x, y, identifier and name.
+using particles_t = soa_dynamic_array<std::tuple<float, float, int, std::string>>;
+using length_t = particles_t::length_t;
+
+void print_array(const particles_t &particles)
+{
+    std::cout << "Particles: [ ";
+    for (length_t i = 0; i < particles.size(); i++) {
+        std::cout << "[" << std::get<3>(particles[i]) << ":" << std::get<2>(particles[i]) << "] ";
+    }
+    std::cout << "]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    particles_t particles;
+    for (int i = 0; i < 100; i++) {
+        particles.emplace_back(float(i), float(2 * i), i, std::string(1, char('A' + i % 26)));
+    }
+    check(particles.size() == 100 && particles.capacity() == 128, "Columns grow together");
+
+    float sum = 0;
+    const float *xs = particles.data<0>();
+    for (length_t i = 0; i < particles.size(); i++) {
+        sum += xs[i];
+    }
+    check(sum == 4950 && particles.column<1>().last() == 198, "Scan a contiguous column");
+
+    std::get<1>(particles[5]) = -1;
+    particles.get<2>(6) = 600;
+    check(particles.data<1>()[5] == -1 && particles.column<2>()[6] == 600, "Write through row references");
+
+    particles.swap_remove(0);
+    particles.shift_remove(1);
+    particles.push_back(std::make_tuple(1.0f, 2.0f, 1000, std::string("Z")));
+    print_array(particles);
+    check(particles.size() == 99 && particles.get<2>(0) == 99 && particles.get<2>(1) == 2 &&
+          particles.get<3>(98) == "Z", "Remove and add rows");
+
+    check(particles.column<2>().linearSearch(600) == 5, "Search a column");
+
+    particles.clear();
+    check(particles.size() == 0 && particles.capacity() == 128, "Clear all columns");
+
+    for (int i = 0; i < 128; i++) {
+        particles.emplace_back(float(i), float(i), i, std::string(32, char('a' + i % 26)));
+    }
+    // The arguments are fields of the array's own first row, while the columns grow.
+    particles.emplace_back(particles.get<0>(0), particles.get<1>(0), particles.get<2>(0), particles.get<3>(0));
+    check(particles.size() == 129 && particles.capacity() > 128 && particles.get<2>(128) == 0 &&
+          particles.get<3>(128) == std::string(32, 'a'), "Add a copy of a row of the array while growing");
+    return failures ? 1 : 0;
+}
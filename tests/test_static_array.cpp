@@ -0,0 +1,96 @@
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "dynamic_array.h"
+#include "static_array.h"
+
+static int failures = 0;
+
+void check(bool condition, const char *msg)
+{
+    printf("%s: %s\n", msg, condition ? "ok" : "FAILED");
+    if (!condition) {
+        failures++;
+    }
+}
+
+static_assert(std::is_same<static_array<int, 255>::length_t, std::uint8_t>::value &&
+              std::is_same<static_array<int, 256>::length_t, std::uint16_t>::value &&
+              std::is_same<static_array<char, 70000>::length_t, std::uint32_t>::value,
+              "the length type is the smallest one holding the capacity");
+static_assert(sizeof(static_array<float, 16>) == 68, "the items are stored inline");
+static_assert(static_array<int, 10>::capacity() == 10, "the capacity is a compile-time constant");
+
+/// Code templated over the array type.
+template <typename Array>
+typename Array::length_t fill_and_search(Array &a)
+{
+    for (int i = 0; i < 20; i++) {
+        a.push_back(i * 2);
+    }
+    a.emplace_back(100);
+    a.shift_remove(0);
+    a.swap_remove(0);
+    a.sort();
+    return a.binarySearch(30) + a.linearSearch(100) + a.count(4) + a.min_index() + a.max_index();
+}
+
+int main(int argc, char *argv[])
+{
+    dynamic_array<int> d;
+    static_array<int, 32> s;
+    check(fill_and_search(d) == fill_and_search(s) && s.size() == 19 && s.view().last() == 100,
+          "Templated code runs on dynamic and static arrays alike");
+
+    static_array<std::string, 4> words(3, std::string(30, 'x'));
+    words.emplace_back("last");
+    check(words.full() && words.last() == "last", "Filling a static array");
+    bool thrown = false;
+    try {
+        words.push_back("overflow");
+    }
+    catch (const std::length_error &) {
+        thrown = true;
+    }
+    check(thrown && words.size() == 4, "Overflowing throws by default");
+    check(words.try_emplace_back("more") == nullptr, "try_emplace_back() on a full array");
+
+    static_array<std::string, 4> copy(words);
+    static_array<std::string, 4> moved(std::move(words));
+    check(copy.size() == 4 && moved.size() == 4 && words.empty() && moved[3] == "last" &&
+          copy[0] == std::string(30, 'x'),
+          "Copying and moving");
+    swap(copy, words);
+    check(copy.empty() && words.size() == 4, "Swapping");
+    words.erase(1, 3);
+    check(words.size() == 2 && words[1] == "last" && words.remove_if([](const std::string &w) { return w == "last"; }) == 1,
+          "Erasing items");
+
+    static_array<int, 8, std::uint8_t, overflow_drops> bounded;
+    for (int i = 0; i < 20; i++) {
+        bounded.push_back(i);
+    }
+    int more[] = {100, 101, 102};
+    bounded.pop_back();
+    bounded.append(more, 3);
+    check(bounded.size() == 8 && bounded[6] == 6 && bounded[7] == 100, "Items that do not fit are dropped");
+
+    static_array<int, 8, std::uint8_t, overflow_asserts> unchecked;
+    for (int i = 0; i < 8; i++) {
+        unchecked.push_back(i);
+    }
+    check(unchecked.full() && unchecked.try_emplace_back(9) == nullptr,
+          "Filling an array without overflow checks");
+
+    thrown = false;
+    try {
+        s[19];
+    }
+    catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    check(thrown, "Indexing past the end throws");
+    return failures ? 1 : 0;
+}